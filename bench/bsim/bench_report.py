@@ -0,0 +1,229 @@
+#!/usr/bin/env python3
+# Copyright (c) 2025 Marconatale Parise.
+# SPDX-License-Identifier: Apache-2.0
+"""
+Turn the console logs of the benchmark central (bench/bsim/central) into a JSON
+report, one entry per scenario (ATT MTU, connection interval, PHY):
+
+    notif_per_s   heart rate + battery notifications received per second
+    drops         notifications the peripheral failed to queue (no staging slot or
+                  refused by the stack) plus its failed flushes, both counted at the
+                  source and read around the same window
+    latency_ms    p50/p90/p99/mean/max sample-to-air latency of the heart rate value
+
+Percentiles come from the power-of-two ms histogram of the peripheral
+(latency_hist.h): the value reported is the upper bound of the bucket, so it is
+an upper estimate within a factor of two.
+
+The logs of the advertising scanner (bench/bsim/scanner, adv_<profile>.log) give
+one entry per probe in 'advertising':
+
+    discovery_ms  scan start to first advertising report
+    events_per_s  advertising events per second (one report per event)
+    airtime_ms_per_s  radio TX time per second: 3 channels x ADV_IND on 1M PHY
+
+The console logs of the peripheral (--perip-log) give the cost per call of the
+last COST line: cycles per adc conversion of each channel and per gpio dispatch,
+cycles and bytes copied per notification (the stock baseline is a build with
+CONFIG_APP_BT_NOTIFY_STOCK=y), per mille of the processing time that falls on
+the estimated connection events, and the rounds and deadline misses of the
+last 'Processing' line (a CONFIG_APP_PROC_LOAD_TEST=y build adds the load thread).
+With the footprint report of the peripheral build (--footprint, written by
+scripts/footprint.py report --json) the RAM/ROM of the application modules is
+added. Against the report of another build (--baseline) the RAM saved, the
+cost saved per call and the mean latency of each scenario are printed: e.g. a
+CONFIG_APP_BT_SYNC=y build against the free running timers.
+
+Exit status is 1 if a log reports an error or has no result.
+"""
+
+import argparse
+import json
+import re
+import sys
+
+BENCH_RE = re.compile(r'BENCH (\{.*\})')
+ADV_RE = re.compile(r'ADV (\{.*\})')
+ERR_RE = re.compile(r'BENCH_ERR (.*)')
+COST_RE = re.compile(r'COST (\{.*\})')
+PROC_RE = re.compile(r'Processing: (\d+) rounds, (\d+) deadline misses .*, max latency (\d+) us')
+PROFILE_RE = re.compile(r'adv_(\w+)\.log$')
+
+ADV_CHANNELS = 3
+ADV_PDU_OVERHEAD = 16   # preamble, access address, header, AdvA, CRC (bytes)
+
+
+def percentile(buckets, p):
+    total = sum(buckets)
+    if total == 0:
+        return None
+    acc = 0
+    for i, n in enumerate(buckets):
+        acc += n
+        if acc * 100 >= total * p:
+            return 1 << i
+    return 1 << (len(buckets) - 1)
+
+
+def scenario(raw):
+    duration_s = raw['duration_ms'] / 1000.0
+    buckets = raw['sent_buckets']
+    return {
+        'mtu': raw['mtu'],
+        'interval_ms': raw['interval_1m25'] * 1.25,
+        'phy': raw['phy'],
+        'duration_s': duration_s,
+        'hrs_rx': raw['hrs_rx'],
+        'bas_rx': raw['bas_rx'],
+        'notif_per_s': round((raw['hrs_rx'] + raw['bas_rx']) / duration_s, 2) if duration_s else 0,
+        'drops': raw['not_queued'] + raw['flush_errors'],
+        'not_queued': raw['not_queued'],
+        'flush_errors': raw['flush_errors'],
+        'latency_ms': {
+            'p50': percentile(buckets, 50),
+            'p90': percentile(buckets, 90),
+            'p99': percentile(buckets, 99),
+            'mean': round(raw['sent_sum_ms'] / raw['sent'], 1) if raw['sent'] else None,
+        },
+        'latency_buckets': buckets,
+    }
+
+
+def probe(path, raw):
+    m = PROFILE_RE.search(path)
+    events_per_s = raw['reports'] * 1000.0 / raw['count_ms']
+    event_us = ADV_CHANNELS * (ADV_PDU_OVERHEAD + raw['adv_len']) * 8
+    return {
+        'profile': m.group(1) if m else path,
+        't_s': raw['t_ms'] / 1000.0,
+        'discovery_ms': raw['discovery_ms'],
+        'events_per_s': round(events_per_s, 2),
+        'airtime_ms_per_s': round(events_per_s * event_us / 1000.0, 3),
+    }
+
+
+def peripheral_cost(paths):
+    cost = {}
+    for path in paths:
+        with open(path, encoding='utf-8', errors='replace') as f:
+            for line in f:
+                m = COST_RE.search(line)
+                if m:
+                    cost = json.loads(m.group(1))
+    return cost
+
+
+def peripheral_processing(paths):
+    proc = {}
+    for path in paths:
+        with open(path, encoding='utf-8', errors='replace') as f:
+            for line in f:
+                m = PROC_RE.search(line)
+                if m:
+                    rounds, misses, max_us = (int(g) for g in m.groups())
+                    proc = {
+                        'rounds': rounds,
+                        'misses': misses,
+                        'miss_rate_pct': round(misses * 100.0 / rounds, 2) if rounds else 0,
+                        'max_latency_us': max_us,
+                    }
+    return proc
+
+
+def app_footprint(path):
+    with open(path, encoding='utf-8') as f:
+        modules = json.load(f)['modules']
+    return {name: usage for name, usage in modules.items() if name.startswith('app/')}
+
+
+COST_UNITS = {'_bytes': 'bytes', '_permille': 'permille'}
+
+
+def print_savings(report, baseline):
+    for name, usage in sorted(report['footprint'].items()):
+        base = baseline.get('footprint', {}).get(name)
+        if base:
+            print(f"{name:24} RAM saved {base['ram'] - usage['ram']:5} B, ROM saved {base['rom'] - usage['rom']:5} B")
+    for key, value in sorted(report['cost'].items()):
+        base = baseline.get('cost', {}).get(key)
+        unit = next((u for suffix, u in COST_UNITS.items() if key.endswith(suffix)), 'cycles')
+        if base is not None:
+            print(f"{key:24} {base - value:5} {unit} saved per call ({base} -> {value})")
+    proc, base_proc = report['processing'], baseline.get('processing')
+    if proc and base_proc:
+        print(f"deadline misses {base_proc['miss_rate_pct']} -> {proc['miss_rate_pct']} %, "
+              f"max latency {base_proc['max_latency_us']} -> {proc['max_latency_us']} us")
+    base_scenarios = {(b['mtu'], b['interval_ms'], b['phy']): b for b in baseline.get('scenarios', [])}
+    for r in report['scenarios']:
+        base = base_scenarios.get((r['mtu'], r['interval_ms'], r['phy']))
+        if base and base['latency_ms']['mean'] is not None and r['latency_ms']['mean'] is not None:
+            print(f"mtu {r['mtu']:3} {r['interval_ms']:6.2f} ms {r['phy']}: mean latency "
+                  f"{base['latency_ms']['mean']} -> {r['latency_ms']['mean']} ms")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--log', nargs='+', required=True, help='central console logs')
+    parser.add_argument('--output', required=True, help='JSON report')
+    parser.add_argument('--perip-log', nargs='*', default=[], help='peripheral console logs')
+    parser.add_argument('--footprint', help='footprint.py report of the peripheral build')
+    parser.add_argument('--baseline', help='report of another build to compare with')
+    args = parser.parse_args()
+
+    results = []
+    probes = []
+    errors = []
+    for path in args.log:
+        found = 0
+        with open(path, encoding='utf-8', errors='replace') as f:
+            for line in f:
+                m = BENCH_RE.search(line)
+                if m:
+                    results.append(scenario(json.loads(m.group(1))))
+                    found += 1
+                    continue
+                m = ADV_RE.search(line)
+                if m:
+                    probes.append(probe(path, json.loads(m.group(1))))
+                    found += 1
+                    continue
+                m = ERR_RE.search(line)
+                if m:
+                    errors.append(f'{path}: {m.group(1)}')
+        if not found:
+            errors.append(f'{path}: no result')
+
+    report = {
+        'scenarios': results,
+        'advertising': probes,
+        'cost': peripheral_cost(args.perip_log),
+        'processing': peripheral_processing(args.perip_log),
+        'footprint': app_footprint(args.footprint) if args.footprint else {},
+        'errors': errors,
+    }
+    with open(args.output, 'w', encoding='utf-8') as f:
+        json.dump(report, f, indent=2)
+        f.write('\n')
+
+    for r in results:
+        lat = r['latency_ms']
+        print(f"mtu {r['mtu']:3} {r['interval_ms']:6.2f} ms {r['phy']}: {r['notif_per_s']:7.2f} notif/s, "
+              f"{r['drops']} drops, latency p50 {lat['p50']} p90 {lat['p90']} p99 {lat['p99']} ms")
+    if report['processing']:
+        proc = report['processing']
+        print(f"processing: {proc['rounds']} rounds, {proc['misses']} deadline misses "
+              f"({proc['miss_rate_pct']} %), max latency {proc['max_latency_us']} us")
+    for p in probes:
+        print(f"{p['profile']:8} t {p['t_s']:6.1f} s: discovery {p['discovery_ms']:5} ms, "
+              f"{p['events_per_s']:6.2f} events/s, airtime {p['airtime_ms_per_s']:.3f} ms/s")
+    if args.baseline:
+        with open(args.baseline, encoding='utf-8') as f:
+            print_savings(report, json.load(f))
+    for e in errors:
+        print(f'error: {e}', file=sys.stderr)
+    return 1 if errors else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,340 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file main.c
+ * @brief scripted central of the BabbleSim benchmark
+ *
+ * Connect to the heart rate peripheral, subscribe heart rate measurement and battery level,
+ * then run every scenario of the table (connection interval x PHY) for BENCH_SCENARIO_MS.
+ * For each scenario one line is printed:
+ *     BENCH {json}
+ * with the notifications received, the peripheral sample-to-air latency histogram delta and 
+ * the delta of the notifications the peripheral failed to queue and of its failed flushes, 
+ * both read from the diagnostics service around the same window. bench_report.py turns these lines in the final report.
+ * The ATT MTU is a build option (CONFIG_BT_L2CAP_TX_MTU), run_bench.sh builds one central per MTU.
+ * The link is encrypted first, so EATT bearers are opened and multiple handle value 
+ * notifications are enabled like the peripheral.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/uuid.h>
+#include <zephyr/bluetooth/gatt.h>
+#include "bt_diag.h"
+#include "latency_hist.h"
+
+#define BENCH_SETTLE_MS     1000    // after a parameter change, before counting
+#define BENCH_SCENARIO_MS   10000
+#define BENCH_TIMEOUT       K_SECONDS(10)
+
+typedef struct
+{
+	uint16_t interval;  // 1.25 ms units
+	uint8_t  phy;       // BT_GAP_LE_PHY_1M / BT_GAP_LE_PHY_2M
+}Bench_scenario_t;
+
+static const Bench_scenario_t scenarios[] = {
+	{6, BT_GAP_LE_PHY_1M}, {12, BT_GAP_LE_PHY_1M}, {24, BT_GAP_LE_PHY_1M}, {40, BT_GAP_LE_PHY_1M}, {80, BT_GAP_LE_PHY_1M},
+	{6, BT_GAP_LE_PHY_2M}, {12, BT_GAP_LE_PHY_2M}, {24, BT_GAP_LE_PHY_2M}, {40, BT_GAP_LE_PHY_2M}, {80, BT_GAP_LE_PHY_2M},
+};
+
+#define LAT_WORDS_PER_STAGE (3 + LAT_BUCKETS)
+#define TX_WORDS            2   // not queued, failed flushes
+
+static struct bt_conn *conn;
+static K_SEM_DEFINE(sem_connected, 0, 1);
+static K_SEM_DEFINE(sem_done, 0, 1);
+static int op_err;
+
+static atomic_t hrs_rx;
+static atomic_t bas_rx;
+
+static uint16_t found_handle;
+static uint8_t diag_value[LAT_STAGE_NUM * LAT_WORDS_PER_STAGE * sizeof(uint32_t)];
+static uint16_t diag_len;
+
+static struct bt_gatt_discover_params discover_params;
+static struct bt_gatt_subscribe_params hrs_sub;
+static struct bt_gatt_subscribe_params bas_sub;
+static struct bt_gatt_read_params read_params;
+static struct bt_gatt_exchange_params mtu_params;
+
+
+/***********************************************************
+ Static Function Definitions
+***********************************************************/
+static bool ad_has_hrs(struct bt_data *data, void *user_data){
+	bool *found = user_data;
+	if (data->type == BT_DATA_UUID16_ALL || data->type == BT_DATA_UUID16_SOME) {
+		for (uint8_t i = 0; i + 1 < data->data_len; i += 2) {
+			if (sys_get_le16(&data->data[i]) == BT_UUID_HRS_VAL) {
+				*found = true;
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static void device_found(const bt_addr_le_t *addr, int8_t rssi, uint8_t type, struct net_buf_simple *ad){
+	bool found = false;
+	if (conn != NULL || (type != BT_GAP_ADV_TYPE_ADV_IND && type != BT_GAP_ADV_TYPE_ADV_DIRECT_IND)) {
+		return;
+	}
+	bt_data_parse(ad, ad_has_hrs, &found);
+	if (found && bt_le_scan_stop() == 0) {
+		if (bt_conn_le_create(addr, BT_CONN_LE_CREATE_CONN, BT_LE_CONN_PARAM_DEFAULT, &conn)) {
+			printk("BENCH_ERR create connection\n");
+		}
+	}
+}
+
+static void connected(struct bt_conn *c, uint8_t err){
+	if (err) {
+		printk("BENCH_ERR connection 0x%02x\n", err);
+		bt_conn_unref(conn);
+		conn = NULL;
+		return;
+	}
+	k_sem_give(&sem_connected);
+}
+
+static void disconnected(struct bt_conn *c, uint8_t reason){
+	printk("BENCH_ERR disconnected 0x%02x\n", reason);
+}
+
+static bool le_param_req(struct bt_conn *c, struct bt_le_conn_param *param){
+	// The benchmark owns the connection parameters
+	return false;
+}
+
+static void le_param_updated(struct bt_conn *c, uint16_t interval, uint16_t latency, uint16_t timeout){
+	k_sem_give(&sem_done);
+}
+
+static void le_phy_updated(struct bt_conn *c, struct bt_conn_le_phy_info *param){
+	k_sem_give(&sem_done);
+}
+
+static void security_changed(struct bt_conn *c, bt_security_t level, enum bt_security_err err){
+	op_err = err;
+	k_sem_give(&sem_done);
+}
+
+BT_CONN_CB_DEFINE(conn_callbacks) = {
+	.connected = connected,
+	.disconnected = disconnected,
+	.le_param_req = le_param_req,
+	.le_param_updated = le_param_updated,
+	.le_phy_updated = le_phy_updated,
+	.security_changed = security_changed,
+};
+
+static uint8_t discover_func(struct bt_conn *c, const struct bt_gatt_attr *attr,
+			     struct bt_gatt_discover_params *params){
+	if (attr != NULL) {
+		found_handle = ((struct bt_gatt_chrc *)attr->user_data)->value_handle;
+	}
+	k_sem_give(&sem_done);
+	return BT_GATT_ITER_STOP;
+}
+
+static uint16_t discover_chrc(const struct bt_uuid *uuid){
+	found_handle = 0;
+	discover_params.uuid = uuid;
+	discover_params.func = discover_func;
+	discover_params.start_handle = BT_ATT_FIRST_ATTRIBUTE_HANDLE;
+	discover_params.end_handle = BT_ATT_LAST_ATTRIBUTE_HANDLE;
+	discover_params.type = BT_GATT_DISCOVER_CHARACTERISTIC;
+	if (bt_gatt_discover(conn, &discover_params) || k_sem_take(&sem_done, BENCH_TIMEOUT)) {
+		return 0;
+	}
+	return found_handle;
+}
+
+static uint8_t notify_func(struct bt_conn *c, struct bt_gatt_subscribe_params *params,
+			   const void *data, uint16_t length){
+	if (data != NULL) {
+		atomic_inc(params == &hrs_sub ? &hrs_rx : &bas_rx);
+	}
+	return BT_GATT_ITER_CONTINUE;
+}
+
+static int subscribe(struct bt_gatt_subscribe_params *params, const struct bt_uuid *uuid){
+	// Both characteristics are declared with their CCC right after the value
+	params->value_handle = discover_chrc(uuid);
+	if (params->value_handle == 0) {
+		return -ENOENT;
+	}
+	params->ccc_handle = params->value_handle + 1;
+	params->value = BT_GATT_CCC_NOTIFY;
+	params->notify = notify_func;
+	return bt_gatt_subscribe(conn, params);
+}
+
+static uint8_t read_func(struct bt_conn *c, uint8_t err, struct bt_gatt_read_params *params,
+			 const void *data, uint16_t length){
+	if (err || data == NULL) {
+		op_err = err;
+		k_sem_give(&sem_done);
+		return BT_GATT_ITER_STOP;
+	}
+	// Long read: called once per chunk
+	length = MIN(length, sizeof(diag_value) - diag_len);
+	memcpy(&diag_value[diag_len], data, length);
+	diag_len += length;
+	return BT_GATT_ITER_CONTINUE;
+}
+
+static int read_diag(uint16_t handle, uint32_t *words, uint16_t num_words){
+	diag_len = 0;
+	read_params.func = read_func;
+	read_params.handle_count = 1;
+	read_params.single.handle = handle;
+	read_params.single.offset = 0;
+	if (bt_gatt_read(conn, &read_params) || k_sem_take(&sem_done, BENCH_TIMEOUT) || op_err) {
+		return -EIO;
+	}
+	for (uint16_t i = 0; i < num_words; i++) {
+		words[i] = (i * 4 < diag_len) ? sys_get_le32(&diag_value[i * 4]) : 0;
+	}
+	return 0;
+}
+
+static void mtu_func(struct bt_conn *c, uint8_t err, struct bt_gatt_exchange_params *params){
+	op_err = err;
+	k_sem_give(&sem_done);
+}
+
+static int set_scenario(const Bench_scenario_t *sc){
+	struct bt_conn_le_phy_param phy = {
+		.options = BT_CONN_LE_PHY_OPT_NONE,
+		.pref_tx_phy = sc->phy,
+		.pref_rx_phy = sc->phy,
+	};
+	k_sem_reset(&sem_done);
+	if (bt_conn_le_param_update(conn, BT_LE_CONN_PARAM(sc->interval, sc->interval, 0, 400)) == 0) {
+		(void)k_sem_take(&sem_done, BENCH_TIMEOUT);
+	}
+	k_sem_reset(&sem_done);
+	if (bt_conn_le_phy_update(conn, &phy) == 0) {
+		(void)k_sem_take(&sem_done, BENCH_TIMEOUT);
+	}
+	return 0;
+}
+
+static int read_snapshot(uint16_t lat_handle, uint16_t tx_handle, uint32_t *lat, uint32_t *tx){
+	if (read_diag(lat_handle, lat, LAT_STAGE_NUM * LAT_WORDS_PER_STAGE) || read_diag(tx_handle, tx, TX_WORDS)) {
+		printk("BENCH_ERR diagnostics read\n");
+		return -EIO;
+	}
+	return 0;
+}
+
+static void print_result(const Bench_scenario_t *sc, uint32_t ms, uint32_t hrs, uint32_t bas,
+			 const uint32_t *before, const uint32_t *after, const uint32_t *tx_before,
+			 const uint32_t *tx_after){
+	const uint32_t *q0 = &before[LAT_STAGE_QUEUED * LAT_WORDS_PER_STAGE];
+	const uint32_t *q1 = &after[LAT_STAGE_QUEUED * LAT_WORDS_PER_STAGE];
+	const uint32_t *s0 = &before[LAT_STAGE_SENT * LAT_WORDS_PER_STAGE];
+	const uint32_t *s1 = &after[LAT_STAGE_SENT * LAT_WORDS_PER_STAGE];
+
+	printk("BENCH {\"mtu\":%u,\"interval_1m25\":%u,\"phy\":\"%s\",\"duration_ms\":%u,"
+	       "\"hrs_rx\":%u,\"bas_rx\":%u,\"queued\":%u,\"sent\":%u,\"not_queued\":%u,\"flush_errors\":%u,"
+	       "\"sent_sum_ms\":%u,\"sent_buckets\":[",
+	       bt_gatt_get_mtu(conn), sc->interval, sc->phy == BT_GAP_LE_PHY_2M ? "2M" : "1M", ms,
+	       hrs, bas, q1[0] - q0[0], s1[0] - s0[0], tx_after[0] - tx_before[0], tx_after[1] - tx_before[1],
+	       s1[2] - s0[2]);
+	for (uint8_t b = 0; b < LAT_BUCKETS; b++) {
+		printk("%s%u", b ? "," : "", s1[3 + b] - s0[3 + b]);
+	}
+	printk("]}\n");
+}
+
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+void main(void){
+	static uint32_t lat_before[LAT_STAGE_NUM * LAT_WORDS_PER_STAGE];
+	static uint32_t lat_after[LAT_STAGE_NUM * LAT_WORDS_PER_STAGE];
+	uint32_t tx_before[TX_WORDS];
+	uint32_t tx_after[TX_WORDS];
+	uint16_t lat_handle;
+	uint16_t tx_handle;
+
+	if (bt_enable(NULL) || bt_le_scan_start(BT_LE_SCAN_ACTIVE, device_found)) {
+		printk("BENCH_ERR bluetooth init\n");
+		return;
+	}
+	if (k_sem_take(&sem_connected, K_SECONDS(30))) {
+		printk("BENCH_ERR peripheral not found\n");
+		return;
+	}
+	// EATT bearers are opened once the link is encrypted
+	if (IS_ENABLED(CONFIG_BT_EATT) && bt_conn_set_security(conn, BT_SECURITY_L2) == 0) {
+		if (k_sem_take(&sem_done, BENCH_TIMEOUT) || op_err) {
+			printk("BENCH_ERR security\n");
+		}
+	}
+
+	if (CONFIG_BT_L2CAP_TX_MTU > 23) {
+		mtu_params.func = mtu_func;
+		if (bt_gatt_exchange_mtu(conn, &mtu_params) == 0) {
+			(void)k_sem_take(&sem_done, BENCH_TIMEOUT);
+		}
+	}
+	lat_handle = discover_chrc(BT_UUID_DIAG_LATENCY);
+	tx_handle = discover_chrc(BT_UUID_DIAG_TX);
+	if (subscribe(&hrs_sub, BT_UUID_HRS_MEASUREMENT) || subscribe(&bas_sub, BT_UUID_BAS_BATTERY_LEVEL) ||
+	    lat_handle == 0 || tx_handle == 0) {
+		printk("BENCH_ERR discovery\n");
+		return;
+	}
+
+	for (uint8_t i = 0; i < ARRAY_SIZE(scenarios); i++) {
+		uint32_t start;
+		uint32_t hrs;
+		uint32_t bas;
+
+		set_scenario(&scenarios[i]);
+		k_sleep(K_MSEC(BENCH_SETTLE_MS));
+		if (read_snapshot(lat_handle, tx_handle, lat_before, tx_before)) {
+			continue;
+		}
+		start = k_uptime_get_32();
+		hrs = (uint32_t)atomic_get(&hrs_rx);
+		bas = (uint32_t)atomic_get(&bas_rx);
+		k_sleep(K_MSEC(BENCH_SCENARIO_MS));
+		hrs = (uint32_t)atomic_get(&hrs_rx) - hrs;
+		bas = (uint32_t)atomic_get(&bas_rx) - bas;
+		if (read_snapshot(lat_handle, tx_handle, lat_after, tx_after)) {
+			continue;
+		}
+		print_result(&scenarios[i], k_uptime_get_32() - start, hrs, bas, lat_before, lat_after, tx_before,
+			     tx_after);
+	}
+	printk("BENCH_DONE\n");
+}
@@ -0,0 +1,42 @@
+#!/usr/bin/env bash
+# Copyright (c) 2025 Marconatale Parise.
+# SPDX-License-Identifier: Apache-2.0
+#
+# Advertising benchmark on BabbleSim: for each advertising profile build the application
+# (peripheral) for nrf52_bsim, run it with the passive scanner (bench/bsim/scanner) and
+# write a JSON report of discovery latency vs. advertising events and airtime.
+#
+# Needs ZEPHYR_BASE and BSIM_OUT_PATH (BabbleSim built, see the Zephyr bsim docs).
+#   PROFILES="latency balanced power"   profiles under test (CONFIG_APP_BT_ADV_PROFILE)
+#   OUT=<dir>                            build and log directory (default build_bench)
+#   SIM_LENGTH_US=<us>                   simulated time of each run
+set -euo pipefail
+
+BENCH_DIR=$(cd "$(dirname "$0")" && pwd)
+APP_DIR=$(cd "$BENCH_DIR/../.." && pwd)
+OUT=${OUT:-$APP_DIR/build_bench}
+PROFILES=${PROFILES:-"latency balanced power"}
+SIM_LENGTH_US=${SIM_LENGTH_US:-145000000}
+: "${ZEPHYR_BASE:?ZEPHYR_BASE not set}"
+: "${BSIM_OUT_PATH:?BSIM_OUT_PATH not set}"
+
+declare -A PROFILE_ID=([latency]=0 [balanced]=1 [power]=2)
+
+mkdir -p "$OUT"
+west build -p auto -b nrf52_bsim -d "$OUT/scanner" "$BENCH_DIR/scanner"
+logs=()
+for profile in $PROFILES; do
+  west build -p auto -b nrf52_bsim -d "$OUT/peripheral_adv_$profile" "$APP_DIR" -- \
+    -DCONFIG_APP_BT_ADV_PROFILE="${PROFILE_ID[$profile]}"
+
+  sim_id="norab106_adv_$profile"
+  log="$OUT/adv_$profile.log"
+  (cd "$BSIM_OUT_PATH/bin" &&
+    "$OUT/peripheral_adv_$profile/zephyr/zephyr.exe" -s="$sim_id" -d=0 > "$OUT/peripheral_adv_$profile.log" 2>&1 &
+    "$OUT/scanner/zephyr/zephyr.exe" -s="$sim_id" -d=1 > "$log" 2>&1 &
+    ./bs_2G4_phy_v1 -s="$sim_id" -D=2 -sim_length="$SIM_LENGTH_US" > "$OUT/phy_adv_$profile.log" 2>&1
+    wait)
+  logs+=("$log")
+done
+
+python3 "$BENCH_DIR/bench_report.py" --log "${logs[@]}" --output "$OUT/adv_report.json"
@@ -0,0 +1,53 @@
+#!/usr/bin/env bash
+# Copyright (c) 2025 Marconatale Parise.
+# SPDX-License-Identifier: Apache-2.0
+#
+# BLE benchmark on BabbleSim: build the application (peripheral) and the scripted
+# central for nrf52_bsim, run them on the simulated 2.4 GHz PHY for each ATT MTU
+# and write a JSON report.
+#
+# Needs ZEPHYR_BASE and BSIM_OUT_PATH (BabbleSim built, see the Zephyr bsim docs).
+#   MTUS="23 247"           ATT MTU values, one build pair each
+#   OUT=<dir>               build and log directory (default build_bench)
+#   SIM_LENGTH_US=<us>      simulated time of each run
+#   BASELINE=<json>         report of another build: print RAM and cycles saved per call
+#   PERIP_ARGS=<args>       extra cmake arguments of the peripheral build, e.g. the stock
+#                           notification baseline: PERIP_ARGS=-DCONFIG_APP_BT_NOTIFY_STOCK=y, or the
+#                           connection event aligned sampling: PERIP_ARGS=-DCONFIG_APP_BT_SYNC=y,
+#                           or the processing load test: PERIP_ARGS=-DCONFIG_APP_PROC_LOAD_TEST=y
+set -euo pipefail
+
+BENCH_DIR=$(cd "$(dirname "$0")" && pwd)
+APP_DIR=$(cd "$BENCH_DIR/../.." && pwd)
+OUT=${OUT:-$APP_DIR/build_bench}
+MTUS=${MTUS:-"23 247"}
+SIM_LENGTH_US=${SIM_LENGTH_US:-150000000}
+PERIP_ARGS=${PERIP_ARGS:-}
+: "${ZEPHYR_BASE:?ZEPHYR_BASE not set}"
+: "${BSIM_OUT_PATH:?BSIM_OUT_PATH not set}"
+
+mkdir -p "$OUT"
+logs=()
+perip_logs=()
+for mtu in $MTUS; do
+  west build -p auto -b nrf52_bsim -d "$OUT/peripheral_$mtu" "$APP_DIR" -- \
+    -DOVERLAY_CONFIG="$BENCH_DIR/peripheral.conf" -DCONFIG_BT_L2CAP_TX_MTU="$mtu" $PERIP_ARGS
+  west build -p auto -b nrf52_bsim -d "$OUT/central_$mtu" "$BENCH_DIR/central" -- \
+    -DCONFIG_BT_L2CAP_TX_MTU="$mtu"
+
+  sim_id="norab106_bench_$mtu"
+  log="$OUT/central_$mtu.log"
+  (cd "$BSIM_OUT_PATH/bin" &&
+    "$OUT/peripheral_$mtu/zephyr/zephyr.exe" -s="$sim_id" -d=0 > "$OUT/peripheral_$mtu.log" 2>&1 &
+    "$OUT/central_$mtu/zephyr/zephyr.exe" -s="$sim_id" -d=1 > "$log" 2>&1 &
+    ./bs_2G4_phy_v1 -s="$sim_id" -D=2 -sim_length="$SIM_LENGTH_US" > "$OUT/phy_$mtu.log" 2>&1
+    wait)
+  logs+=("$log")
+  perip_logs+=("$OUT/peripheral_$mtu.log")
+done
+
+# Module footprint of the last peripheral build, the MTU only changes bluetooth buffers
+python3 "$APP_DIR/scripts/footprint.py" report --map "$OUT/peripheral_$mtu/zephyr/zephyr.map" \
+  --json "$OUT/footprint.json" > /dev/null
+python3 "$BENCH_DIR/bench_report.py" --log "${logs[@]}" --output "$OUT/bench_report.json" \
+  --perip-log "${perip_logs[@]}" --footprint "$OUT/footprint.json" ${BASELINE:+--baseline "$BASELINE"}
@@ -0,0 +1,129 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file main.c
+ * @brief passive scanner of the BabbleSim advertising benchmark
+ *
+ * The peripheral boots with the simulation and is never connected, so it runs its fast 
+ * advertising burst and then stays in the slow tier. At each probe time of the table the 
+ * scanner starts a continuous passive scan (window = interval) and measures the time to 
+ * the first advertising report of the heart rate peripheral (discovery latency), then counts 
+ * its reports for ADV_COUNT_MS: with a continuous scan each advertising event gives one report.
+ * For each probe one line is printed:
+ *     ADV {json}
+ * bench_report.py turns these lines in the advertising report (discovery latency, events/s
+ * and radio airtime).
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/uuid.h>
+
+#define ADV_DISCOVERY_TIMEOUT_MS  10000
+#define ADV_COUNT_MS              5000
+
+#define ADV_SCAN_CONTINUOUS BT_LE_SCAN_PARAM(BT_LE_SCAN_TYPE_PASSIVE, BT_LE_SCAN_OPT_NONE, \
+					     BT_GAP_SCAN_FAST_INTERVAL, BT_GAP_SCAN_FAST_INTERVAL)
+
+// Probe start times since boot (ms): fast burst of every profile, then slow tier
+static const uint32_t probes_ms[] = {500, 2500, 5000, 8000, 15000, 25000, 40000, 70000, 100000, 130000};
+
+static K_SEM_DEFINE(sem_found, 0, 1);
+static atomic_t reports;
+static uint32_t first_ms;
+static uint8_t adv_len;
+
+
+/***********************************************************
+ Static Function Definitions
+***********************************************************/
+static bool ad_has_hrs(struct bt_data *data, void *user_data){
+	bool *found = user_data;
+	if (data->type == BT_DATA_UUID16_ALL || data->type == BT_DATA_UUID16_SOME) {
+		for (uint8_t i = 0; i + 1 < data->data_len; i += 2) {
+			if (sys_get_le16(&data->data[i]) == BT_UUID_HRS_VAL) {
+				*found = true;
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static void device_found(const bt_addr_le_t *addr, int8_t rssi, uint8_t type, struct net_buf_simple *ad){
+	bool found = false;
+	uint8_t len = ad->len;
+
+	if (type != BT_GAP_ADV_TYPE_ADV_IND) {
+		return;
+	}
+	bt_data_parse(ad, ad_has_hrs, &found);
+	if (!found) {
+		return;
+	}
+	if (atomic_inc(&reports) == 0) {
+		first_ms = k_uptime_get_32();
+		adv_len = len;
+		k_sem_give(&sem_found);
+	}
+}
+
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+void main(void){
+	if (bt_enable(NULL)) {
+		printk("BENCH_ERR bluetooth init\n");
+		return;
+	}
+
+	for (uint8_t i = 0; i < ARRAY_SIZE(probes_ms); i++) {
+		uint32_t start;
+		uint32_t count;
+
+		if (k_uptime_get_32() < probes_ms[i]) {
+			k_sleep(K_MSEC(probes_ms[i] - k_uptime_get_32()));
+		}
+		atomic_set(&reports, 0);
+		k_sem_reset(&sem_found);
+		start = k_uptime_get_32();
+		if (bt_le_scan_start(ADV_SCAN_CONTINUOUS, device_found)) {
+			printk("BENCH_ERR scan start\n");
+			return;
+		}
+		if (k_sem_take(&sem_found, K_MSEC(ADV_DISCOVERY_TIMEOUT_MS))) {
+			bt_le_scan_stop();
+			printk("BENCH_ERR peripheral not found at %u ms\n", start);
+			continue;
+		}
+		// Count from the first report, so the interval is not biased by the discovery
+		k_sleep(K_MSEC(ADV_COUNT_MS - (k_uptime_get_32() - first_ms)));
+		count = (uint32_t)atomic_get(&reports) - 1U;
+		bt_le_scan_stop();
+
+		printk("ADV {\"t_ms\":%u,\"discovery_ms\":%u,\"reports\":%u,\"count_ms\":%u,\"adv_len\":%u}\n",
+		       start, first_ms - start, count, ADV_COUNT_MS, adv_len);
+	}
+	printk("BENCH_DONE\n");
+}
@@ -0,0 +1,168 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file accel_fifo.h
+ * @brief this file handles an optional LIS2DH/LIS3DH accelerometer used as motion reference
+ * for the heart rate channel.
+ *
+ * The accelerometer is the I2C node with alias accel0 (see accel.overlay). Its hardware FIFO 
+ * runs in stream mode and raises INT1 at the watermark: the FIFO is then drained with one 
+ * burst read of all the stored samples instead of one transfer per sample. Each sample is 
+ * time stamped back from the watermark interrupt at the output data rate, so it can be 
+ * aligned with the adc samples (cycle counter time base).
+ * The drain runs as a work item of the processing workqueue, the same thread that processes 
+ * the adc samples, so the motion history needs no locking.
+ *
+ * The registers are accessed directly on the bus: keep CONFIG_LIS2DH disabled, the Zephyr 
+ * sensor driver does not expose the FIFO.
+ *
+ * The following functions will be implemented:
+ * - accel_fifo_init() : Check the accelerometer and configure FIFO, watermark and interrupt.
+ * - accel_fifo_start() : Start draining the FIFO on a workqueue.
+ * - accel_fifo_ready() : Check if the accelerometer is available.
+ * - accel_fifo_ref_at() : Get the motion reference samples preceding a timestamp.
+ * - accel_fifo_get_stats() : Get bus transfers, samples and cpu cost.
+ * - accel_fifo_report() : Print bus load and cost per sample.
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+
+#ifndef __ACCEL_FIFO_H__
+#define __ACCEL_FIFO_H__
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include "common.h"
+
+#if DT_NODE_EXISTS(DT_ALIAS(accel0))
+#define ACCEL_ENABLED 1
+#else
+#define ACCEL_ENABLED 0
+#endif
+
+/* LIS2DH / LIS3DH registers */
+#define ACCEL_REG_WHO_AM_I    0x0F
+#define ACCEL_REG_CTRL1       0x20
+#define ACCEL_REG_CTRL3       0x22
+#define ACCEL_REG_CTRL4       0x23
+#define ACCEL_REG_CTRL5       0x24
+#define ACCEL_REG_OUT_X_L     0x28
+#define ACCEL_REG_FIFO_CTRL   0x2E
+#define ACCEL_REG_FIFO_SRC    0x2F
+#define ACCEL_REG_AUTO_INC    0x80  // register address auto increment for burst reads
+
+#define ACCEL_WHO_AM_I        0x33
+#define ACCEL_CTRL1_50HZ_XYZ  0x47  // ODR 50 Hz, x/y/z enabled
+#define ACCEL_CTRL3_I1_WTM    0x04  // FIFO watermark on INT1
+#define ACCEL_CTRL4_BDU_HR    0x88  // block data update, high resolution, +-2 g
+#define ACCEL_CTRL5_FIFO_EN   0x40
+#define ACCEL_FIFO_STREAM     0x80
+#define ACCEL_FIFO_SRC_OVRN   0x40
+#define ACCEL_FIFO_SRC_FSS    0x1F
+
+#define ACCEL_ODR_HZ          50
+#define ACCEL_FIFO_DEPTH      32
+#define ACCEL_FIFO_WATERMARK  16    // samples per interrupt, one drain every 320 ms
+#define ACCEL_DRAIN_TIMEOUT_MS (2 * 1000 * ACCEL_FIFO_WATERMARK / ACCEL_ODR_HZ) // drain even if an edge is lost
+#define ACCEL_HIST_LEN        64    // motion reference history, must be a power of two
+
+BUILD_ASSERT(ACCEL_FIFO_WATERMARK < ACCEL_FIFO_DEPTH, "watermark must leave room in the FIFO");
+BUILD_ASSERT(IS_POWER_OF_TWO(ACCEL_HIST_LEN), "history length must be a power of two");
+
+typedef struct
+{
+  uint32_t  bus_xfers;    // i2c transactions
+  uint32_t  drains;       // FIFO drains
+  uint32_t  samples;      // samples read from the FIFO
+  uint32_t  overruns;     // drains that found the FIFO overrun
+  uint32_t  cycles_total; // cpu cycles spent draining
+}Accel_stats_t;
+
+
+/**
+ * @brief Initialize the accelerometer
+ *
+ * Check the device identity, configure output data rate, FIFO in stream mode with 
+ * watermark and the INT1 interrupt.
+ *
+ * no @param
+ *
+ * @return int 0 on success, -ENODEV when no accelerometer is configured or found
+ */
+int accel_fifo_init(void);
+
+/**
+ * @brief Start FIFO draining
+ *
+ * Drains run on the given workqueue on each watermark interrupt, and at least every 
+ * ACCEL_DRAIN_TIMEOUT_MS.
+ *
+ * @param queue workqueue running the adc processing
+ *
+ * @return void
+ */
+void accel_fifo_start(struct k_work_q *queue);
+
+/**
+ * @brief Check if the accelerometer is available
+ *
+ * no @param
+ *
+ * @return bool true if accel_fifo_init() succeeded
+ */
+bool accel_fifo_ready(void);
+
+/**
+ * @brief Get motion reference
+ *
+ * Copy the last n motion reference samples (acceleration magnitude minus its mean, mg) 
+ * taken at or before ts_cyc, oldest first.
+ *
+ * @param ts_cyc timestamp in cycles of the sample to be aligned
+ * @param ref array to be filled
+ * @param n number of samples requested
+ * @param max_skew_cyc maximum distance between ts_cyc and the newest reference sample
+ *
+ * @return bool true if n aligned samples are available
+ */
+bool accel_fifo_ref_at(uint32_t ts_cyc, int16_t *ref, uint8_t n, uint32_t max_skew_cyc);
+
+/**
+ * @brief Get accelerometer statistics
+ *
+ * @param stats pointer to the struct to be filled
+ *
+ * @return void
+ */
+void accel_fifo_get_stats(Accel_stats_t *stats);
+
+/**
+ * @brief Print accelerometer statistics
+ *
+ * Bus transfers and samples per second, cycles per sample and FIFO overruns.
+ * Nothing is printed without an accelerometer.
+ *
+ * no @param
+ *
+ * @return void
+ */
+void accel_fifo_report(void);
+
+#endif
@@ -25,7 +25,25 @@
  * - data_is_valid() : Check if the new data is valid based on ranges.
  * - spike_counter() : If data is not valid, increment the spike counter for the specific channel in the adc abstract array.
  * - adc_get_media() : Calculate the average of the data in the FIFO buffer for a specific channel in the adc abstract array.
+ * - adc_sample_ch() : Start a conversion of a channel, the result is queued in the sample ring.
+ * - adc_process_samples() : Drain the sample ring and store the samples in the FIFO buffer of their channel.
  * - adc_read_ch_data() : Read data from the adc abstract pins and store it in the FIFO buffer for each channel.
+ * - adc_rate_update() : Adapt the sample period of a channel to the activity of its signal.
+ * - adc_channel_is_due() : Check if a channel has to be sampled.
+ * - adc_next_due_ms() : Get the time until the next channel has to be sampled.
+ * - adc_get_period_ms() : Get the current sample period of a channel.
+ * - adc_get_conversions() : Get the number of conversions done on a channel.
+ * - adc_calib_request() : Request an offset calibration with the next conversion.
+ * - adc_get_perf() : Get cpu cost, noise and calibration statistics of a channel.
+ * - adc_get_quality() : Get glitch statistics and signal quality index of a channel.
+ * - adc_signal_usable() : Check if the signal quality of a channel is good enough to be sent.
+ * - adc_get_ring_stats() : Get overrun and occupancy statistics of the sample ring.
+ * - adc_get_sample_cyc() : Get the conversion timestamp of the newest sample in the average.
+ * - adc_filter_set() : Install a filter applied to each sample of a channel before the glitch check.
+ * - adc_tune_set() : Change sample period limits, average window and glitch thresholds of a channel.
+ * - adc_tune_get() : Get the tuning of a channel.
+ * - adc_filter_len_max() : Get the longest average window of a channel.
+ * - adc_report() : Print conversions, cost, quality and ring statistics.
  * 
  * 
  * @author Marconatale Parise
@@ -40,6 +58,7 @@
 #include <zephyr/devicetree.h>
 #include <zephyr/drivers/adc.h>
 #include "common.h"
+#include "spsc_ring.h"
 
 
 #if !DT_NODE_EXISTS(DT_PATH(zephyr_user)) || !DT_NODE_HAS_PROP(DT_PATH(zephyr_user), io_channels)
@@ -71,30 +90,158 @@ static const struct adc_dt_spec adc_channels[] = {
 #define LIMIT_ADC_SPIKE 3 // spike detected and data is valid
 #define VDD	3300.0F            
 #define RANGE   (4096*300)/VDD   //300mV range for 12bit resolution and VDD=3.3V
+#define RANGE_MV 300              // same range in mV, the glitch check runs on mV samples
 #define ADC_RESOLUTION 12
 
 #define HR_CH 0
 #define BATT_CH 1
 
-#define BUFFER_SIZE 5 // number of samples to store in the buffer 
+/* Channel ids are checked once here against devicetree: functions taking a channel don't test it 
+ * at run time (only with CONFIG_ASSERT), callers use these ids or loop up to ADC_NUM_CHANNELS. */
+BUILD_ASSERT(HR_CH < ADC_NUM_CHANNELS && BATT_CH < ADC_NUM_CHANNELS, "adc channel id out of io-channels");
+
+#define BUFFER_SIZE 16 // preallocated samples of the buffer, upper limit of the average window
+#define ADC_FILTER_LEN 5 // default average window, can be changed at run time (adc_tune_set())
+
+/* Activity-adaptive sample period: the period drops to the minimum as soon as the signal moves 
+ * more than the threshold (slope from the previous sample or distance from the media), 
+ * otherwise it doubles up to the maximum. */
+#define HR_RATE_MIN_MS      100
+#define HR_RATE_MAX_MS      1600
+#define HR_RATE_THR_MV      33      // ~1 bpm
+#define BATT_RATE_MIN_MS    1000
+#define BATT_RATE_MAX_MS    60000
+#define BATT_RATE_THR_MV    33      // ~1 %
+
+/* Channels with zephyr,oversampling in devicetree average in hardware (SAADC burst mode), 
+ * the software window is then reduced to ADC_SW_AVG_OVERSAMPLED samples. */
+#define ADC_SW_AVG_OVERSAMPLED  2
+
+/* Offset calibration runs with the next conversion (sequence.calibrate) every 
+ * ADC_CALIB_INTERVAL_MS, or earlier when the die temperature (die-temp0 alias) drifts. */
+#define ADC_CALIB_INTERVAL_MS   600000
+#define ADC_CALIB_TEMP_CHECK_MS 10000
+#define ADC_CALIB_TEMP_DELTA_C  5
+
+#define ADC_FIXED_PERIOD_MS 100     // fixed sample period used as baseline in the report
+
+#if DT_NODE_EXISTS(DT_ALIAS(die_temp0)) && defined(CONFIG_SENSOR)
+#define ADC_CALIB_USE_DIE_TEMP  1
+#else
+#define ADC_CALIB_USE_DIE_TEMP  0
+#endif
+
+/* Signal quality index (0..100) computed after each sample from the reject rate, the 
+ * consecutive rejects and the noise estimate. Below SQI_MIN_USABLE the value is not sent. */
+#define SQI_MAX               100
+#define SQI_MIN_USABLE        50
+#define SQI_REJECT_WEIGHT     2     // SQI points lost for each % of rejected samples
+#define SQI_CONSEC_WEIGHT     10    // SQI points lost for each consecutive reject
+#define SQI_NOISE_FULL_MV     100   // noise that alone brings the SQI to zero
+
+/* Conversions are pushed by the adc completion callback (interrupt context) in a lock-free 
+ * single producer / single consumer ring, the processing stage drains it ADC_RING_BATCH at a time. */
+#define ADC_RING_BATCH  8
+
+#define ADC_CAPTURE 0 // print each conversion as "ADC_CAP,ts,ch,raw,mV" for scripts/adc_capture.py
+
+/* Millivolts of a 12-bit conversion always fit 16 bits, samples are stored saturated to this type */
+typedef uint16_t adc_sample_t;
+
+#define ADC_SAMPLE_MAX UINT16_MAX
 
 typedef struct 
 {
-  uint8_t    length; // index of the data in the buffer
-  int32_t	 data_set[BUFFER_SIZE];
-  int32_t   data_media;
-  uint16_t   count; 
+  uint8_t       length; // index of the data in the buffer
+  uint8_t       count;
+  adc_sample_t  data_set[BUFFER_SIZE];
+  adc_sample_t  data_media;
 }Fifo_buf_t;
 
+typedef struct
+{
+  uint16_t min_period_ms;
+  uint16_t max_period_ms;
+  uint16_t thr_mv;
+}Adc_rate_cfg_t;
+
+typedef struct
+{
+  uint16_t  range_mv;     // distance from the last sample accepted without glitch check, mV
+  uint8_t   limit;        // consecutive samples out of range taken as a real step
+}Adc_glitch_cfg_t;
+
+/* Run time tuning of a channel, the window is resized inside the preallocated buffer */
+typedef struct
+{
+  uint16_t  min_period_ms;
+  uint16_t  max_period_ms;
+  uint8_t   filter_len;     // average window, 1..BUFFER_SIZE
+  uint16_t  spike_range_mv;  // mV, compared with samples already converted to mV
+  uint8_t   spike_limit;
+}Adc_tune_t;
+
+typedef struct
+{
+  uint32_t  period_ms;    // current sample period
+  uint32_t  next_ms;      // uptime of the next sample
+  uint32_t  conversions;  // conversions done on the channel
+  adc_sample_t last;      // previous sample, used for the slope
+}Adc_rate_t;
+
+typedef struct
+{
+  uint32_t  cycles_total;   // cpu cycles spent in conversion and processing of the channel
+  uint32_t  cycles_max;
+  uint32_t  calibrations;   // offset calibrations done with a conversion of the channel
+  uint32_t  noise_q8;       // mean absolute deviation from the media, mV in Q8
+}Adc_perf_t;
+
+typedef struct
+{
+  uint32_t  samples;          // samples evaluated by the glitch stage
+  uint32_t  rejects;          // samples dropped as glitches
+  uint16_t  reject_rate_q12;  // exponential average of rejects, fraction in Q12
+  uint8_t   max_consec;       // longest run of consecutive rejects
+  uint8_t   sqi;              // signal quality index 0..SQI_MAX
+}Adc_quality_t;
+
+/* Per-sample filter, gets the sample in mV and its conversion timestamp in cycles */
+typedef adc_sample_t (*adc_filter_t)(adc_sample_t sample, uint32_t ts_cyc);
+
+typedef struct
+{
+  uint32_t  overruns;     // samples dropped because the ring was full
+  uint32_t  pending;      // samples waiting to be processed
+  uint32_t  max_pending;  // highest occupancy seen by the processing stage
+}Adc_ring_stats_t;
+
+/* Run time state of a channel, the constant configuration stays in flash (adc_channels[], 
+ * devicetree) */
 typedef struct 
 {
-	uint8_t			pin;
-	bool 			  status;
-	Fifo_buf_t		fbuf;
   uint8_t     counter_spike;
-  
+	Fifo_buf_t		fbuf;
+  Adc_rate_t  rate;
+  Adc_perf_t  perf;
+  Adc_quality_t quality;
+  uint32_t    sample_cyc;   // conversion timestamp of the newest sample in the FIFO
 }Adc_t;
 
+/**
+ * @brief Saturate a millivolt value to the sample storage type
+ *
+ * @param mv millivolt value returned by the adc conversion
+ *
+ * @return adc_sample_t value clamped to [0, ADC_SAMPLE_MAX]
+ */
+static inline adc_sample_t adc_sample_sat(int32_t mv){
+  if (mv < 0){
+    return 0;
+  }
+  return (mv > ADC_SAMPLE_MAX) ? ADC_SAMPLE_MAX : (adc_sample_t)mv;
+}
+
 
 
 /**
@@ -115,12 +262,11 @@ void adc_init();
  * Add new data to the FIFO buffer for a specific channel in the adc abstract array.
  *
  * @param channel 8-bit value that indicate channel of adc abstract array 
- * @param data_read 16-bit value new data to be added to the buffer
- * @param size 8-bit value that indicate number of adc abstract array 
+ * @param data_read 32-bit value new data to be added to the buffer, saturated to 16 bits
  *
  * @return void
  */
-void Ff_buffer_add(uint8_t channel, int32_t data_read, uint8_t size);
+void Ff_buffer_add(uint8_t channel, int32_t data_read);
 
 /**
  * @brief verify data validity
@@ -130,24 +276,23 @@ void Ff_buffer_add(uint8_t channel, int32_t data_read, uint8_t size);
  * @param a 8-bit struct pointer to an n-element data array
  * @param channel 8-bit value that indicate channel of adc abstract array 
  * @param data_read 16-bit value new data to be added to the buffer
- * @param size 8-bit value that indicate number of adc abstract array 
  *
  * @return bool true if data is valid, false otherwise
  */
-bool data_is_valid(uint8_t channel, uint16_t data_read, uint8_t size);
+bool data_is_valid(uint8_t channel, uint16_t data_read);
 
 /**
  * @brief count number of spikes
  *
  * If data is not valid, increment the spike counter for the specific channel in the adc abstract array.
+ * Validity is evaluated once per call, so call it exactly once for each sample.
  *
  * @param channel 8-bit value that indicate channel of adc abstract array 
  * @param data_read 16-bit value new data to be added to the buffer
- * @param size 8-bit value that indicate number of adc abstract array 
  *
  * @return uint8_t the number of spikes detected for the specific channel
  */
-uint8_t spike_counter(uint8_t channel,  uint16_t data_read, uint8_t size);
+uint8_t spike_counter(uint8_t channel,  uint16_t data_read);
 
 /**
  * @brief Get media from three samples
@@ -155,11 +300,34 @@ uint8_t spike_counter(uint8_t channel,  uint16_t data_read, uint8_t size);
  * Calculate the average of the data in the FIFO buffer for a specific channel in the adc abstract array.
  *
  * @param channel 8-bit value that indicate channel of adc abstract array 
- * @param size 8-bit value that indicate number of adc abstract array 
  *
  * @return uint16_t the calculated average value
  */
-uint16_t adc_get_media (uint8_t channel, uint8_t size);
+uint16_t adc_get_media (uint8_t channel);
+
+/**
+ * @brief Start a conversion of a channel
+ *
+ * Run one conversion of the channel (with the offset calibration when due). The result is 
+ * pushed in the sample ring by the completion callback, call adc_process_samples() to use it.
+ *
+ * @param channel 8-bit value that indicate channel of adc abstract array 
+ *
+ * @return int 0 on success, negative error code otherwise
+ */
+int adc_sample_ch(uint8_t channel);
+
+/**
+ * @brief Process queued samples
+ *
+ * Consumer side of the sample ring: convert every queued sample to mV, check it for glitches, 
+ * update rate, quality and FIFO media of its channel. Must be called by a single thread.
+ *
+ * no @param
+ *
+ * @return uint32_t number of samples processed
+ */
+uint32_t adc_process_samples(void);
 
 /**
  * @brief Read data from adc abstract pins
@@ -168,11 +336,180 @@ uint16_t adc_get_media (uint8_t channel, uint8_t size);
  *
  * @param a 8-bit struct pointer to an n-element data array
  * @param channel 8-bit value that indicate channel of adc abstract array 
- * @param size 8-bit value that indicate number of adc abstract array 
  *
  * @return uint16_t the read data value for the specific channel
  */
-uint16_t adc_read_ch_data (uint8_t channel, uint8_t size);
+uint16_t adc_read_ch_data (uint8_t channel);
+
+/**
+ * @brief Adapt the sample period of a channel
+ *
+ * Set the period to the minimum when the new sample moves more than the channel threshold,
+ * otherwise back off doubling the period up to the maximum. The next sample is scheduled
+ * one period after now.
+ *
+ * @param channel 8-bit value that indicate channel of adc abstract array 
+ * @param sample new sample of the channel
+ *
+ * @return uint32_t the new sample period in ms
+ */
+uint32_t adc_rate_update(uint8_t channel, adc_sample_t sample);
+
+/**
+ * @brief Check if a channel has to be sampled
+ *
+ * @param channel 8-bit value that indicate channel of adc abstract array 
+ * @param now_ms current uptime in ms
+ *
+ * @return bool true if the sample period of the channel is elapsed
+ */
+bool adc_channel_is_due(uint8_t channel, uint32_t now_ms);
+
+/**
+ * @brief Get time until the next sample
+ *
+ * @param now_ms current uptime in ms
+ *
+ * @return uint32_t ms until the first channel has to be sampled, 0 if a channel is already due
+ */
+uint32_t adc_next_due_ms(uint32_t now_ms);
+
+/**
+ * @brief Get sample period of a channel
+ *
+ * @param channel 8-bit value that indicate channel of adc abstract array 
+ *
+ * @return uint32_t current sample period in ms
+ */
+uint32_t adc_get_period_ms(uint8_t channel);
+
+/**
+ * @brief Get conversions of a channel
+ *
+ * @param channel 8-bit value that indicate channel of adc abstract array 
+ *
+ * @return uint32_t number of conversions done on the channel since boot
+ */
+uint32_t adc_get_conversions(uint8_t channel);
+
+/**
+ * @brief Request an offset calibration
+ *
+ * The calibration is done together with the next conversion of any channel, so acquisition 
+ * is never stopped to calibrate.
+ *
+ * no @param
+ *
+ * @return void
+ */
+void adc_calib_request(void);
+
+/**
+ * @brief Get channel performance statistics
+ *
+ * @param channel 8-bit value that indicate channel of adc abstract array 
+ * @param perf pointer to the struct to be filled
+ *
+ * @return void
+ */
+void adc_get_perf(uint8_t channel, Adc_perf_t *perf);
+
+/**
+ * @brief Get channel signal quality
+ *
+ * @param channel 8-bit value that indicate channel of adc abstract array 
+ * @param quality pointer to the struct to be filled
+ *
+ * @return void
+ */
+void adc_get_quality(uint8_t channel, Adc_quality_t *quality);
+
+/**
+ * @brief Check if the signal of a channel is usable
+ *
+ * @param channel 8-bit value that indicate channel of adc abstract array 
+ *
+ * @return bool true if the signal quality index is at least SQI_MIN_USABLE
+ */
+bool adc_signal_usable(uint8_t channel);
+
+/**
+ * @brief Get sample ring statistics
+ *
+ * @param stats pointer to the struct to be filled
+ *
+ * @return void
+ */
+void adc_get_ring_stats(Adc_ring_stats_t *stats);
+
+/**
+ * @brief Get newest sample timestamp
+ *
+ * @param channel 8-bit value that indicate channel of adc abstract array 
+ *
+ * @return uint32_t cycle counter at the conversion complete of the newest sample in the FIFO
+ */
+uint32_t adc_get_sample_cyc(uint8_t channel);
+
+/**
+ * @brief Install a channel filter
+ *
+ * The filter runs in the processing stage on each sample of the channel, before the 
+ * glitch check and the average.
+ *
+ * @param channel 8-bit value that indicate channel of adc abstract array 
+ * @param filter filter function, NULL to remove it
+ *
+ * @return void
+ */
+void adc_filter_set(uint8_t channel, adc_filter_t filter);
+
+/**
+ * @brief Change the tuning of a channel
+ *
+ * Must be called from the processing stage, between two samples. A shorter window keeps the 
+ * newest samples, the current sample period is clamped to the new limits and a faster next 
+ * sample is brought forward. The window can't be longer than adc_filter_len_max(): a longer 
+ * one is rejected, not shortened, so the tuning read back is the one written.
+ *
+ * @param channel 8-bit value that indicate channel of adc abstract array 
+ * @param tune new tuning
+ *
+ * @return 0 on success, -EINVAL if a value is out of range
+ */
+int adc_tune_set(uint8_t channel, const Adc_tune_t *tune);
+
+/**
+ * @brief Get the tuning of a channel
+ *
+ * @param channel 8-bit value that indicate channel of adc abstract array 
+ * @param tune pointer to the struct to be filled
+ *
+ * @return void
+ */
+void adc_tune_get(uint8_t channel, Adc_tune_t *tune);
+
+/**
+ * @brief Get the longest average window of a channel
+ *
+ * @param channel 8-bit value that indicate channel of adc abstract array 
+ *
+ * @return uint8_t ADC_SW_AVG_OVERSAMPLED for channels with hardware oversampling, else BUFFER_SIZE
+ */
+uint8_t adc_filter_len_max(uint8_t channel);
+
+/**
+ * @brief Print the adc statistics
+ *
+ * For each channel the conversions per hour compared to the fixed ADC_FIXED_PERIOD_MS 
+ * baseline, cpu cycles per conversion, noise, calibrations and signal quality, then the 
+ * sample ring overruns.
+ *
+ * no @param
+ *
+ * @return void
+ */
+void adc_report(void);
 
 
 #endif
\ No newline at end of file
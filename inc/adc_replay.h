@@ -0,0 +1,81 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file adc_replay.h
+ * @brief this file provides the replay backend of the adc abstract layer: samples captured on the 
+ * board (ADC_CAPTURE) are fed back through the Zephyr ADC emulator, so that the processing chain 
+ * can be run deterministically on native_posix. Each conversion takes the next captured sample 
+ * of its channel: no sample is skipped or repeated, ADC_REPLAY_SPEED only divides the sampling 
+ * periods so the capture is replayed that many times faster.
+ *
+ * The following functions will be implemented:
+ * - adc_replay_init() : Connect the replay table to the ADC emulator channels.
+ * - adc_replay_report() : Print the replay statistics.
+ * 
+ * The replay table is generated at build time by scripts/adc_capture.py from the 
+ * ADC_REPLAY_CAPTURE console log.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+
+#ifndef __ADC_REPLAY_H__
+#define __ADC_REPLAY_H__
+
+#include "adc_abstract.h"
+
+#define ADC_REPLAY_SPEED        1     // sampling period divider, 1 = same timing of the capture
+#define ADC_REPLAY_DEFAULT_MV   1650  // value fed when the capture has no sample for a channel
+
+typedef struct
+{
+  uint32_t ts_ms;   // time from the first captured sample
+  uint8_t  channel;
+  uint16_t mv;
+}Adc_replay_sample_t;
+
+typedef struct
+{
+  uint32_t fed;     // conversions served by the replay backend
+  uint32_t loops;   // number of times the capture restarted from the beginning
+}Adc_replay_stats_t;
+
+
+/**
+ * @brief Initialize adc replay
+ *
+ * Connect the replay table to the ADC emulator channels. To be called after adc_init().
+ *
+ * no @param
+ *
+ * @return int 0 on success, negative error code otherwise
+ */
+int adc_replay_init(void);
+
+/**
+ * @brief Print adc replay report
+ *
+ * Print samples fed, capture loops and replay time compared to the uptime.
+ *
+ * no @param
+ *
+ * @return void
+ */
+void adc_replay_report(void);
+
+#endif
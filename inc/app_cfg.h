@@ -0,0 +1,177 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file app_cfg.h
+ * @brief this file handles the run time parameters: heart rate sample period limits, 
+ * notification period, average window and glitch thresholds.
+ *
+ * A new set of parameters is checked as a whole and staged, then applied at once by the 
+ * TASK_CONFIG task on the processing workqueue, between two sampling rounds: the sampling 
+ * and DSP stages never see half of an update. The average window is resized inside the 
+ * preallocated buffer of adc_abstract (BUFFER_SIZE), no memory is allocated. Applied 
+ * parameters are stored in settings ("cfg/params", wire format) and restored at boot. The 
+ * flash is written at most once every APP_CFG_SAVE_MIN_MS, sets accepted in between are 
+ * coalesced into the next write.
+ *
+ * Parameters are written through the vendor control service (bt_ctrl.h) or the shell 
+ * ("cfg show", "cfg set <name> <value>"). Wire format (APP_CFG_WIRE_LEN bytes, little endian): 
+ * sample_min_ms uint16, sample_max_ms uint16, notify_period_ms uint32, filter_len uint8, 
+ * spike_range_mv uint16, spike_limit uint8. The glitch threshold is in mV, as the samples 
+ * it is compared with. The average window applies to every adc channel, so it is checked 
+ * against the shortest adc_filter_len_max() of the channels (ADC_SW_AVG_OVERSAMPLED with 
+ * hardware oversampling): the value stored and read back is the one applied.
+ *
+ * The following functions will be implemented:
+ * - app_cfg_init() : Fit the default average window to the adc channels.
+ * - app_cfg_set() : Check and stage a new set of parameters.
+ * - app_cfg_get() : Get the current parameters.
+ * - app_cfg_apply() : Apply the staged parameters, task of the scheduler.
+ * - app_cfg_encode() : Encode parameters in the wire format.
+ * - app_cfg_decode() : Decode parameters from the wire format.
+ * - app_cfg_get_stats() : Get update counters.
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+
+#ifndef __APP_CFG_H__
+#define __APP_CFG_H__
+
+#include <zephyr/kernel.h>
+#include "common.h"
+
+#define APP_CFG_WIRE_LEN        12
+
+/* Limits: conversion and DSP of a round must fit the fastest period, the sample periods 
+ * are stored on 16 bits */
+#define APP_CFG_SAMPLE_MIN_MS   20
+#define APP_CFG_SAMPLE_MAX_MS   60000
+#define APP_CFG_NOTIFY_MIN_MS   100
+#define APP_CFG_NOTIFY_MAX_MS   3600000
+#define APP_CFG_SPIKE_MAX_MV    3300
+#define APP_CFG_SPIKE_LIMIT_MAX 16
+
+/* Minimum time between two flash writes of the parameters */
+#define APP_CFG_SAVE_MIN_MS     10000
+
+typedef struct
+{
+  uint16_t  sample_min_ms;      // heart rate sample period while the signal moves
+  uint16_t  sample_max_ms;      // heart rate sample period reached with a stable signal
+  uint32_t  notify_period_ms;   // heart rate notification period
+  uint8_t   filter_len;         // average window of the adc channels, 1..app_cfg_filter_len_max()
+  uint16_t  spike_range_mv;     // glitch threshold from the last sample, mV
+  uint8_t   spike_limit;        // consecutive glitches taken as a real step
+}App_cfg_t;
+
+typedef struct
+{
+  uint32_t  updates;    // parameter sets applied
+  uint32_t  rejects;    // parameter sets refused by the check
+  uint32_t  saves;      // parameter sets stored in settings
+  uint32_t  coalesced;  // accepted sets replaced by a newer one before being stored
+}App_cfg_stats_t;
+
+
+/**
+ * @brief Fit the default average window to the adc channels
+ *
+ * Called once at boot, before settings are loaded: the default ADC_FILTER_LEN is shortened 
+ * to app_cfg_filter_len_max(), as adc_init() did for the channels.
+ *
+ * no @param
+ *
+ * @return void
+ */
+void app_cfg_init(void);
+
+/**
+ * @brief Get the longest average window accepted
+ *
+ * no @param
+ *
+ * @return uint8_t shortest adc_filter_len_max() of the adc channels
+ */
+uint8_t app_cfg_filter_len_max(void);
+
+/**
+ * @brief Check and stage new parameters
+ *
+ * The parameters are applied by the next run of TASK_CONFIG and stored in settings, at 
+ * most once every APP_CFG_SAVE_MIN_MS.
+ *
+ * @param cfg new parameters
+ *
+ * @return 0 on success, -EINVAL if a value is out of range (nothing is changed)
+ */
+int app_cfg_set(const App_cfg_t *cfg);
+
+/**
+ * @brief Get the current parameters
+ *
+ * The last accepted set, it may still be waiting for TASK_CONFIG.
+ *
+ * @param cfg pointer to the struct to be filled
+ *
+ * @return void
+ */
+void app_cfg_get(App_cfg_t *cfg);
+
+/**
+ * @brief Apply the staged parameters
+ *
+ * Task of the scheduler (TASK_CONFIG), runs on the processing workqueue. It also stores 
+ * the applied set, or re-arms itself as a one-shot run when the last write is too recent.
+ *
+ * no @param
+ *
+ * @return void
+ */
+void app_cfg_apply(void);
+
+/**
+ * @brief Encode parameters
+ *
+ * @param cfg parameters
+ * @param buf destination, APP_CFG_WIRE_LEN bytes
+ *
+ * @return void
+ */
+void app_cfg_encode(const App_cfg_t *cfg, uint8_t *buf);
+
+/**
+ * @brief Decode parameters
+ *
+ * @param buf source
+ * @param len length of the source, must be APP_CFG_WIRE_LEN
+ * @param cfg pointer to the struct to be filled
+ *
+ * @return 0 on success, -EMSGSIZE on a wrong length
+ */
+int app_cfg_decode(const uint8_t *buf, uint16_t len, App_cfg_t *cfg);
+
+/**
+ * @brief Get update counters
+ *
+ * @param stats pointer to the struct to be filled
+ *
+ * @return void
+ */
+void app_cfg_get_stats(App_cfg_stats_t *stats);
+
+#endif
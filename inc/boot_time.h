@@ -0,0 +1,86 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file boot_time.h
+ * @brief this file provides a small instrumentation interface to timestamp the boot milestones
+ * of the application (peripheral bring-up, bluetooth ready, first advertisement, first sample).
+ *
+ * The following functions will be implemented:
+ * - boot_time_mark() : Record the time of a boot milestone (only the first occurrence is kept).
+ * - boot_time_get_us() : Get the recorded time of a boot milestone.
+ * - boot_time_report() : Print the boot milestones recorded so far.
+ *
+ * Times are measured from the start of the system clock, which is the closest point to the
+ * reset that the kernel can observe.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+
+#ifndef __BOOT_TIME_H__
+#define __BOOT_TIME_H__
+
+#include <zephyr/kernel.h>
+#include "common.h"
+
+typedef enum
+{
+  BOOT_EVT_BT_ENABLE = 0,   // bt_enable() requested, network core is booting
+  BOOT_EVT_PERIPH_READY,    // gpio and adc initialized
+  BOOT_EVT_BT_READY,        // bluetooth ready callback invoked
+  BOOT_EVT_FIRST_ADV,       // first advertisement started
+  BOOT_EVT_FIRST_SAMPLE,    // first adc sample available
+  BOOT_EVT_NUM
+}Boot_evt_t;
+
+
+/**
+ * @brief Mark a boot milestone
+ *
+ * Record the time of a boot milestone. Only the first call for each milestone is stored, 
+ * next calls are ignored. When all milestones are recorded the report is printed.
+ *
+ * @param evt milestone to be recorded
+ *
+ * @return void
+ */
+void boot_time_mark(Boot_evt_t evt);
+
+/**
+ * @brief Get boot milestone time
+ *
+ * Get the time of a boot milestone in microseconds from the start of the system clock.
+ *
+ * @param evt milestone to be read
+ *
+ * @return uint32_t time in microseconds, 0 if the milestone is not reached yet
+ */
+uint32_t boot_time_get_us(Boot_evt_t evt);
+
+/**
+ * @brief Print boot report
+ *
+ * Print the boot milestones recorded so far.
+ *
+ * no @param
+ *
+ * @return void
+ */
+void boot_time_report(void);
+
+#endif
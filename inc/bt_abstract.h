@@ -46,8 +46,12 @@
 #include <zephyr/bluetooth/conn.h>
 #include <zephyr/bluetooth/uuid.h>
 #include <zephyr/bluetooth/gatt.h>
-#include <zephyr/bluetooth/services/bas.h>
 #include <zephyr/bluetooth/services/hrs.h>
+#include "boot_time.h"
+#include "latency_hist.h"
+#include "bt_notify.h"
+
+#define BT_READY_TIMEOUT_MS 5000 // max time to wait for the network core to be ready
 
 static const struct bt_data ad[] = {
 	BT_DATA_BYTES(BT_DATA_FLAGS, (BT_LE_AD_GENERAL | BT_LE_AD_NO_BREDR)),
@@ -58,10 +62,34 @@ static const struct bt_data ad[] = {
 };
 
 
+/**
+ * @brief Enable bluetooth asynchronously
+ *
+ * Request bt_enable() with a ready callback so that the caller can go on with the peripheral 
+ * initialization while the network core boots. Advertising is started and auth callbacks are
+ * registered from the ready callback.
+ *
+ * @param no parameters
+ *
+ * @return int 0 if the request is accepted, negative error code otherwise
+ */
+int bt_init_async(void);
+
+/**
+ * @brief Wait bluetooth ready
+ *
+ * Block the caller until the bluetooth ready callback is executed or the timeout expires.
+ *
+ * @param timeout max time to wait
+ *
+ * @return bool true if bluetooth is ready, false otherwise
+ */
+bool bt_wait_ready(k_timeout_t timeout);
+
 /**
  * @brief Bluetooth ready function
  *
- * Initialize bluetooth and start advertising with the specified parameters.
+ * Load bonds and last peer from settings and start the advertising sequence (bt_adv.c).
  *
  * @param no parameters
  *
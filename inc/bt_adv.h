@@ -0,0 +1,193 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file bt_adv.h
+ * @brief this file handles advertising and the fast reconnection of bonded peers.
+ *
+ * Advertising is restarted from the system workqueue each time a disconnected link is released. 
+ * With a bonded peer the sequence is:
+ * - high duty cycle directed advertising to the last bonded peer (1.28 s),
+ * - undirected advertising filtered by the accept list of the bonded peers (BT_ADV_ACCEPT_LIST_MS),
+ * - open undirected advertising, so that new centrals can pair.
+ * Without bonds advertising is open from the start. Without CONFIG_BT_FILTER_ACCEPT_LIST 
+ * (prj_minimal.conf) the accept list step is skipped: directed advertising is followed by 
+ * open advertising, still in the fast burst. The last bonded peer is kept in 
+ * settings ("app/peer"), bonds by the bluetooth stack (CONFIG_BT_SETTINGS).
+ *
+ * Undirected advertising follows the duty cycle of the selected profile: a fast burst 
+ * after each restart, then slow intervals until a central connects. The profile is chosen 
+ * at build time (CONFIG_APP_BT_ADV_PROFILE) and can be changed at run time.
+ *
+ * The reconnect time is measured from the disconnection to the first notification delivered,
+ * the time to connect from the advertising restart to the connection. The advertising airtime
+ * is estimated from the time spent in each interval and the PDU length.
+ *
+ * The following functions will be implemented:
+ * - bt_adv_start() : Start the advertising sequence.
+ * - bt_adv_peer_bonded() : Remember a peer as the last bonded one.
+ * - bt_adv_peer_deleted() : Forget a deleted bond.
+ * - bt_adv_notify_delivered() : Close the reconnect time measurement.
+ * - bt_adv_profile_set() : Select the advertising profile.
+ * - bt_adv_profile_get() : Get the advertising profile.
+ * - bt_adv_get_stats() : Get reconnect time, time to connect and airtime counters.
+ * - bt_adv_report() : Print reconnect, time to connect and airtime statistics.
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+
+#ifndef __BT_ADV_H__
+#define __BT_ADV_H__
+
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/addr.h>
+#include "common.h"
+
+#define BT_ADV_FAST_RECONNECT   1       // 0: always open advertising, reconnect time baseline
+#define BT_ADV_ACCEPT_LIST_MS   30000   // bonded peers only, then open to new centrals
+
+typedef enum {
+  BT_ADV_DIRECTED = 0,
+  BT_ADV_ACCEPT_LIST,
+  BT_ADV_OPEN,
+  BT_ADV_MODE_NUM
+}Bt_adv_mode_t;
+
+typedef enum {
+  BT_ADV_TIER_FAST = 0,
+  BT_ADV_TIER_SLOW,
+  BT_ADV_TIER_NUM
+}Bt_adv_tier_t;
+
+typedef enum {
+  BT_ADV_PROFILE_LATENCY = 0,   // long fast burst, slow intervals ~160 ms
+  BT_ADV_PROFILE_BALANCED,      // 30 s fast burst, slow intervals ~1 s
+  BT_ADV_PROFILE_POWER,         // short burst, slow intervals ~2 s
+  BT_ADV_PROFILE_NUM
+}Bt_adv_profile_id_t;
+
+typedef struct
+{
+  const char *name;
+  uint32_t    fast_ms;            // fast burst length after a restart
+  uint16_t    fast_int_min;       // 0.625 ms units
+  uint16_t    fast_int_max;
+  uint16_t    slow_int_min;
+  uint16_t    slow_int_max;
+}Bt_adv_profile_t;
+
+typedef struct
+{
+  uint32_t  reconnects;                   // disconnection to first notification cycles
+  uint32_t  last_ms;
+  uint32_t  max_ms;
+  uint32_t  sum_ms;
+  uint32_t  connections[BT_ADV_MODE_NUM]; // connections made in each advertising mode
+  uint32_t  connects;                     // advertising restart to connection cycles
+  uint32_t  ttc_last_ms;
+  uint32_t  ttc_max_ms;
+  uint32_t  ttc_sum_ms;
+  uint32_t  adv_ms[BT_ADV_TIER_NUM];      // time spent advertising in each tier
+  uint32_t  adv_events;                   // estimated advertising events
+  uint32_t  airtime_ms;                   // estimated radio TX time
+}Bt_adv_stats_t;
+
+
+/**
+ * @brief Start advertising
+ *
+ * To be called when bluetooth is ready and settings are loaded.
+ *
+ * no @param
+ *
+ * @return void
+ */
+void bt_adv_start(void);
+
+/**
+ * @brief Remember the last bonded peer
+ *
+ * Safe from the bluetooth callbacks: the settings write is deferred to the advertising work.
+ *
+ * @param peer identity address of the peer
+ *
+ * @return void
+ */
+void bt_adv_peer_bonded(const bt_addr_le_t *peer);
+
+/**
+ * @brief Forget a deleted bond
+ *
+ * @param peer identity address of the deleted bond
+ *
+ * @return void
+ */
+void bt_adv_peer_deleted(const bt_addr_le_t *peer);
+
+/**
+ * @brief Notification delivered
+ *
+ * Called on each notification sent, the first one after a disconnection closes the 
+ * reconnect time measurement.
+ *
+ * no @param
+ *
+ * @return void
+ */
+void bt_adv_notify_delivered(void);
+
+/**
+ * @brief Select the advertising profile
+ *
+ * A running undirected advertising set is restarted with the intervals of the new profile,
+ * the fast burst is not restarted.
+ *
+ * @param id profile
+ *
+ * @return int 0 on success, -EINVAL if id is out of range
+ */
+int bt_adv_profile_set(Bt_adv_profile_id_t id);
+
+/**
+ * @brief Get the advertising profile
+ *
+ * no @param
+ *
+ * @return const Bt_adv_profile_t* current profile
+ */
+const Bt_adv_profile_t *bt_adv_profile_get(void);
+
+/**
+ * @brief Get advertising statistics
+ *
+ * @param stats pointer to the struct to be filled
+ *
+ * @return void
+ */
+void bt_adv_get_stats(Bt_adv_stats_t *stats);
+
+/**
+ * @brief Print advertising statistics
+ *
+ * no @param
+ *
+ * @return void
+ */
+void bt_adv_report(void);
+
+#endif
@@ -0,0 +1,46 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file bt_ctrl.h
+ * @brief this file defines the vendor control GATT service.
+ *
+ * Characteristics (all values little endian):
+ * - Config (read, write with encryption): run time parameters in the wire format of 
+ *   app_cfg.h (APP_CFG_WIRE_LEN bytes). A write replaces the whole set: a wrong length 
+ *   is refused with "invalid attribute value length", a value out of range with 
+ *   "value not allowed", in both cases nothing is changed.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+
+#ifndef __BT_CTRL_H__
+#define __BT_CTRL_H__
+
+#include <zephyr/bluetooth/uuid.h>
+#include "common.h"
+
+#define BT_UUID_CTRL_VAL \
+	BT_UUID_128_ENCODE(0x6e4f0101, 0x8b1a, 0x4c53, 0x9d0e, 0x4e4f52414231)
+#define BT_UUID_CTRL_CONFIG_VAL \
+	BT_UUID_128_ENCODE(0x6e4f0102, 0x8b1a, 0x4c53, 0x9d0e, 0x4e4f52414231)
+
+#define BT_UUID_CTRL         BT_UUID_DECLARE_128(BT_UUID_CTRL_VAL)
+#define BT_UUID_CTRL_CONFIG  BT_UUID_DECLARE_128(BT_UUID_CTRL_CONFIG_VAL)
+
+#endif
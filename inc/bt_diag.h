@@ -0,0 +1,49 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file bt_diag.h
+ * @brief this file defines the vendor diagnostics GATT service.
+ *
+ * Characteristics (all values little endian):
+ * - Latency (read): for each stage of latency_hist.h (queued, sent) count, max ms, 
+  *   sum ms and LAT_BUCKETS bucket counters, all uint32.
+ * - TX (read): notifications not queued and failed flushes of bt_notify.h, both uint32, read 
+ *   in one snapshot.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+
+#ifndef __BT_DIAG_H__
+#define __BT_DIAG_H__
+
+#include <zephyr/bluetooth/uuid.h>
+#include "common.h"
+
+#define BT_UUID_DIAG_VAL \
+	BT_UUID_128_ENCODE(0x6e4f0001, 0x8b1a, 0x4c53, 0x9d0e, 0x4e4f52414231)
+#define BT_UUID_DIAG_LATENCY_VAL \
+	BT_UUID_128_ENCODE(0x6e4f0002, 0x8b1a, 0x4c53, 0x9d0e, 0x4e4f52414231)
+#define BT_UUID_DIAG_TX_VAL \
+	BT_UUID_128_ENCODE(0x6e4f0003, 0x8b1a, 0x4c53, 0x9d0e, 0x4e4f52414231)
+
+#define BT_UUID_DIAG         BT_UUID_DECLARE_128(BT_UUID_DIAG_VAL)
+#define BT_UUID_DIAG_LATENCY BT_UUID_DECLARE_128(BT_UUID_DIAG_LATENCY_VAL)
+#define BT_UUID_DIAG_TX      BT_UUID_DECLARE_128(BT_UUID_DIAG_TX_VAL)
+
+#endif
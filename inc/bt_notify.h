@@ -0,0 +1,176 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file bt_notify.h
+ * @brief this file handles the grouped notification path: the values changed in an update 
+ * cycle (heart rate, battery level, vendor characteristics) are staged and then sent together.
+ *
+ * Each staged value is sent with bt_gatt_notify_cb(). With CONFIG_BT_GATT_NOTIFY_MULTIPLE the 
+ * stack merges the values of a flush in one Multiple Handle Value Notification (over EATT when 
+ * enabled) for peers that enabled the feature in the client supported features, and sends 
+ * single notifications to the other peers.
+ *
+ * The battery service is defined here instead of CONFIG_BT_BAS: the stock service notifies 
+ * inside bt_bas_set_battery_level(), so its value could not join a group.
+ *
+ * Values are encoded in place: bt_notify_stage_enc() runs the encoder of the characteristic 
+ * on the staging slot, which is the buffer handed to the stack, so the only copy left is the 
+ * one of the stack into the PDU. bt_notify_stage() copies a value already encoded.
+ *
+ * A flush only submits as many values as there are free TX credits (BT_NOTIFY_TX_CREDITS, 
+ * the TX buffers with a sent callback of the connection): the stack never waits for a 
+ * buffer on the caller workqueue. A value without credit stays staged for the next flush, 
+ * a newer value of the same characteristic replaces it. A credit comes back in the sent 
+ * callback of the value.
+ *
+ * With CONFIG_APP_BT_NOTIFY_STOCK the heart rate is sent with bt_hrs_notify() of the stock 
+ * service instead, as the baseline of the cycles and bytes copied per notification.
+ *
+ * The following functions will be implemented:
+ * - bt_notify_stage() : Stage the value of a characteristic for the next flush.
+ * - bt_notify_stage_enc() : Stage a value encoded in place.
+ * - bt_notify_stage_hrs() : Stage a heart rate measurement with its latency stamp.
+ * - bt_notify_stage_bas() : Update the battery level and stage its notification.
+ * - bt_notify_flush() : Send all staged values.
+ * - bt_hrs_notify_stamped() : Send a heart rate measurement alone.
+ * - bt_notify_get_stats() : Get flushes, values, credits, copies and errors counters.
+ * - bt_notify_report() : Print the notification statistics.
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+
+#ifndef __BT_NOTIFY_H__
+#define __BT_NOTIFY_H__
+
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/gatt.h>
+#include "common.h"
+
+#define BT_NOTIFY_MAX_VALUES  4   // characteristics that can be staged in a cycle
+#define BT_NOTIFY_MAX_LEN     20  // max staged value length, fits the default ATT MTU
+#define BT_NOTIFY_TX_CREDITS  CONFIG_BT_CONN_TX_MAX // values in flight, shared by the connections
+
+/* Encode src into buf, the length is the one given to bt_notify_stage_enc() */
+typedef void (*Bt_notify_enc_t)(const void *src, uint8_t *buf);
+
+typedef struct
+{
+  uint32_t  flushes;    // flushes with at least one value
+  uint32_t  values;     // values sent
+  uint32_t  grouped;    // flushes with more than one value
+  uint32_t  errors;     // flushes failed
+  uint32_t  not_queued; // values lost at the source: no staging slot or refused by the stack
+  uint32_t  deferred;   // values kept for the next flush, no TX credit
+  uint32_t  exhausted;  // flushes failed with the stack out of buffers
+  uint32_t  inflight_max;   // max values waiting for the sent callback
+  uint32_t  bytes_encoded;  // bytes encoded in place in the staging slots
+  uint32_t  bytes_copied;   // bytes copied: staged copies and the stack copy into the PDU
+  uint32_t  cycles_total;   // cpu cycles spent staging and sending
+}Bt_notify_stats_t;
+
+
+/**
+ * @brief Stage a value
+ *
+ * A value staged again before the flush replaces the previous one.
+ *
+ * @param attr characteristic declaration or value attribute
+ * @param data value to be sent, copied
+ * @param len value length, at most BT_NOTIFY_MAX_LEN
+ *
+ * @return int 0 on success, -ENOMEM if no slot is free, -EINVAL if the value is too long
+ */
+int bt_notify_stage(const struct bt_gatt_attr *attr, const void *data, uint16_t len);
+
+/**
+ * @brief Stage a value encoded in place
+ *
+ * The encoder writes len bytes straight into the staging slot, under the path lock.
+ *
+ * @param attr characteristic declaration or value attribute
+ * @param len value length, at most BT_NOTIFY_MAX_LEN
+ * @param enc encoder of the characteristic
+ * @param src argument of enc
+ *
+ * @return int 0 on success, -ENOMEM if no slot is free, -EINVAL if the value is too long
+ */
+int bt_notify_stage_enc(const struct bt_gatt_attr *attr, uint16_t len, Bt_notify_enc_t enc,
+			const void *src);
+
+/**
+ * @brief Stage a heart rate measurement
+ *
+ * @param heartrate heart rate in bpm
+ * @param sample_cyc cycle counter at the adc conversion complete of the newest sample used
+ *
+ * @return int 0 on success, negative error code otherwise
+ */
+int bt_notify_stage_hrs(uint8_t heartrate, uint32_t sample_cyc);
+
+/**
+ * @brief Update and stage the battery level
+ *
+ * @param level battery level 0..100 %
+ *
+ * @return int 0 on success, negative error code otherwise
+ */
+int bt_notify_stage_bas(uint8_t level);
+
+/**
+ * @brief Send all staged values
+ *
+ * no @param
+ *
+ * @return int 0 on success (also with nothing staged or without credits), negative error code 
+ * otherwise
+ */
+int bt_notify_flush(void);
+
+/**
+ * @brief Notify heart rate with latency stamps
+ *
+ * Stage and flush a heart rate measurement alone. The latency from the adc conversion is 
+ * recorded when the notification is queued and when it is sent.
+ *
+ * @param heartrate heart rate in bpm
+ * @param sample_cyc cycle counter at the adc conversion complete of the newest sample used
+ *
+ * @return int 0 on success, negative error code otherwise
+ */
+int bt_hrs_notify_stamped(uint8_t heartrate, uint32_t sample_cyc);
+
+/**
+ * @brief Get notification statistics
+ *
+ * @param stats pointer to the struct to be filled
+ *
+ * @return void
+ */
+void bt_notify_get_stats(Bt_notify_stats_t *stats);
+
+/**
+ * @brief Print notification statistics
+ *
+ * no @param
+ *
+ * @return void
+ */
+void bt_notify_report(void);
+
+#endif
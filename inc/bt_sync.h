@@ -0,0 +1,121 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file bt_sync.h
+ * @brief this file handles the estimate of the connection event timing, used to align the 
+ * heart rate sampling and notification to the connection events (CONFIG_APP_BT_SYNC) and to 
+ * measure how much processing work falls on the radio activity.
+ *
+ * The controller runs on the network core and gives no connection event callback to the 
+ * application core, so the anchor is estimated from the host:
+ * - the connection interval comes from the connection callbacks,
+ * - a notification is acknowledged by the first packet of the central in a connection event, 
+ *   so its sent callback comes a short and nearly constant delay after an anchor point: the 
+ *   anchor phase (time modulo the interval) follows the earliest sent callback phase, an 
+ *   earlier phase is taken at once and a later one slowly (drift of the central clock).
+ *
+ * With the estimate, bt_sync_next_ms() gives the delay to a lead time before the next 
+ * connection event: the sampling, DSP and encoding done there are queued to the controller 
+ * just in time for it. Without estimate (not connected, no notification sent yet) the caller 
+ * falls back to the free running timers.
+ *
+ * bt_sync_cpu_busy() adds the work of the processing workqueue and its overlap with the 
+ * estimated radio windows (BT_SYNC_EVENT_US from each anchor), in both modes.
+ *
+ * The following functions will be implemented:
+ * - bt_sync_sent() : Add the timestamp of a notification sent callback.
+ * - bt_sync_next_ms() : Get the delay to a lead time before the next connection event.
+ * - bt_sync_cpu_busy() : Add a busy period of the processing workqueue.
+ * - bt_sync_get_stats() : Get the estimate, aligned runs and overlap counters.
+ * - bt_sync_report() : Print the estimate and the overlap with the radio.
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+
+#ifndef __BT_SYNC_H__
+#define __BT_SYNC_H__
+
+#include <zephyr/kernel.h>
+#include "common.h"
+
+#define BT_SYNC_MIN_SAMPLES   3       // sent callbacks before the estimate is used
+#define BT_SYNC_DRIFT_SHIFT   2       // a later phase moves the estimate by 1/4 of the difference
+#define BT_SYNC_EVENT_US      2500    // radio window from the anchor, one notification and the empty PDUs
+
+typedef struct
+{
+  uint32_t  interval_us;    // connection interval, 0 if not connected
+  uint32_t  anchor_us;      // estimated anchor phase, valid with samples >= BT_SYNC_MIN_SAMPLES
+  uint32_t  samples;        // sent callbacks of the current connection parameters
+  uint32_t  aligned;        // runs armed before a connection event
+  uint32_t  unaligned;      // runs without estimate, free running
+  uint64_t  busy_us;        // processing workqueue busy time, while the estimate is valid
+  uint64_t  overlap_us;     // of which inside the estimated radio windows
+}Bt_sync_stats_t;
+
+
+/**
+ * @brief Add a notification sent callback
+ *
+ * Called from the sent callback of the notification path, at the callback time.
+ *
+ * no @param
+ *
+ * @return void
+ */
+void bt_sync_sent(void);
+
+/**
+ * @brief Get the delay to a lead time before the next connection event
+ *
+ * @param lead_us time before the anchor, covers the work done and the completion delay
+ * @param delay_ms pointer to the delay to be filled
+ *
+ * @return bool false if there is no estimate
+ */
+bool bt_sync_next_ms(uint32_t lead_us, uint32_t *delay_ms);
+
+/**
+ * @brief Add a busy period of the processing workqueue
+ *
+ * @param busy_cyc cycles of the period, ending now
+ *
+ * @return void
+ */
+void bt_sync_cpu_busy(uint32_t busy_cyc);
+
+/**
+ * @brief Get sync statistics
+ *
+ * @param stats pointer to the struct to be filled
+ *
+ * @return void
+ */
+void bt_sync_get_stats(Bt_sync_stats_t *stats);
+
+/**
+ * @brief Print sync statistics
+ *
+ * no @param
+ *
+ * @return void
+ */
+void bt_sync_report(void);
+
+#endif
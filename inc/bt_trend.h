@@ -0,0 +1,85 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file bt_trend.h
+ * @brief this file defines the vendor trend GATT service, values computed on the device over 
+ * a window of samples.
+ *
+ * Characteristics (all values little endian):
+ * - Summary (read, notify): one record per aggregation window (hr_agg.h), BT_TREND_SUMMARY_LEN 
+ *   bytes: seq uint16, window_s uint16, count uint16 (saturated), min uint8, max uint8, mean uint16 
+ *   (0.1 bpm), p10 uint8, p50 uint8, p90 uint8. Mean and percentiles are weighted by the 
+ *   sampling period of each value. Windows without usable samples are not sent, their seq 
+ *   is skipped.
+ * - HRV (read, notify, CONFIG_APP_HRV only): synthetic metrics of the sliding RR window 
+ *   (hrv.h), BT_TREND_HRV_LEN bytes: 
+ *   beats uint16, mean RR uint16 (ms), SDNN uint16 (0.1 ms), RMSSD uint16 (0.1 ms), 
+ *   pNN50 uint16 (0.1 %). Notified with each summary.
+ *
+ * The following functions will be implemented:
+ * - bt_trend_stage_summary() : Stage the summary of a window for the next notification flush.
+ * - bt_trend_stage_hrv() : Stage the HRV metrics for the next notification flush.
+ *
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+
+#ifndef __BT_TREND_H__
+#define __BT_TREND_H__
+
+#include <zephyr/bluetooth/uuid.h>
+#include "common.h"
+#include "hr_agg.h"
+#include "hrv.h"
+
+#define BT_UUID_TREND_VAL \
+	BT_UUID_128_ENCODE(0x6e4f0201, 0x8b1a, 0x4c53, 0x9d0e, 0x4e4f52414231)
+#define BT_UUID_TREND_SUMMARY_VAL \
+	BT_UUID_128_ENCODE(0x6e4f0202, 0x8b1a, 0x4c53, 0x9d0e, 0x4e4f52414231)
+#define BT_UUID_TREND_HRV_VAL \
+	BT_UUID_128_ENCODE(0x6e4f0203, 0x8b1a, 0x4c53, 0x9d0e, 0x4e4f52414231)
+
+#define BT_UUID_TREND         BT_UUID_DECLARE_128(BT_UUID_TREND_VAL)
+#define BT_UUID_TREND_SUMMARY BT_UUID_DECLARE_128(BT_UUID_TREND_SUMMARY_VAL)
+#define BT_UUID_TREND_HRV     BT_UUID_DECLARE_128(BT_UUID_TREND_HRV_VAL)
+
+#define BT_TREND_SUMMARY_LEN  13
+#define BT_TREND_HRV_LEN      10
+
+
+/**
+ * @brief Stage a window summary
+ *
+ * @param summary summary of the closed window
+ *
+ * @return int 0 on success, negative error code of bt_notify_stage_enc() otherwise
+ */
+int bt_trend_stage_summary(const Hr_agg_summary_t *summary);
+
+/**
+ * @brief Stage the HRV metrics
+ *
+ * Only built with CONFIG_APP_HRV.
+ *
+ * @param metrics metrics of the RR window
+ *
+ * @return int 0 on success, negative error code of bt_notify_stage_enc() otherwise
+ */
+int bt_trend_stage_hrv(const Hrv_metrics_t *metrics);
+
+#endif
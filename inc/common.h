@@ -30,11 +30,13 @@
 #define DEBUG 1
 #define DEBUG_BT 0
 #define DEBUG_ADC 0
+#define DEBUG_BOOT 1
 
 #if DEBUG
 #define LOG(x,...) if(DEBUG){printf("[%u ms] " x "\n", k_uptime_get_32(), ##__VA_ARGS__);}
 #define LOG_BT(x,...) if(DEBUG_BT){printf("[%u ms] " x "\n", k_uptime_get_32(), ##__VA_ARGS__);}
 #define LOG_ADC(x,...) if(DEBUG_ADC){printf("[%u ms] " x "\n", k_uptime_get_32(), ##__VA_ARGS__);}
+#define LOG_BOOT(x,...) if(DEBUG_BOOT){printf("[%u ms] " x "\n", k_uptime_get_32(), ##__VA_ARGS__);}
 #endif
 
 #define   ERROR_ADC_INIT    BIT(5) //error verified during void Analog_init()
@@ -42,4 +44,10 @@
 
 #define   PUSH_BTN(x)        BIT(x)
 
+/* Exponential average step with weight 1 / 2^shift, rounded so it converges to the target 
+ * instead of stopping 2^shift - 1 units away from it */
+static inline int32_t ema_step(int32_t avg, int32_t target, uint8_t shift){
+  return avg + ((target - avg + (1 << (shift - 1))) >> shift);
+}
+
 #endif
\ No newline at end of file
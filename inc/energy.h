@@ -0,0 +1,121 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file energy.h
+ * @brief this file handles the energy estimation: runtime counters multiplied by a per-event 
+ * cost table of the nRF5340 give the charge drawn since boot and the average current.
+ *
+ * Sources:
+ * - cpu active time of the application core, total and per thread (CONFIG_SCHED_THREAD_USAGE_ALL),
+ * - adc conversions (adc_abstract),
+ * - radio events: advertising events (bt_adv), connection events (connected time / interval), 
+ *   notifications sent (bt_notify),
+ * - flash writes (settings), counted with energy_count(),
+ * - a constant floor for system on idle with RTC running.
+ * The radio runs on the network core, its events are estimated from the host counters. The 
+ * model is the same on native_posix, so a replayed workload (adc_replay) gives comparable 
+ * figures in CI without hardware: only the difference between two firmware builds is meaningful.
+ *
+ * The following functions will be implemented:
+ * - energy_count() : Count an event not tracked by other modules.
+ * - energy_cost_set() : Change the cost of an event.
+ * - energy_get() : Get counters, charge per source and average current.
+ * - energy_report() : Print the energy estimation.
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+
+#ifndef __ENERGY_H__
+#define __ENERGY_H__
+
+#include <zephyr/kernel.h>
+#include "common.h"
+
+/* nRF5340 cost table, 3 V with DC/DC, 0 dBm (charge of one event in nC) */
+#define ENERGY_NC_ADC_CONV      20      // SAADC acquisition + conversion, ~1.2 mA for ~15 us
+#define ENERGY_NC_ADV_EVENT     9000    // 3 x (ADV_IND TX + RX window), HFXO startup, net core
+#define ENERGY_NC_CONN_EVENT    3500    // empty connection event, RX + TX
+#define ENERGY_NC_NOTIFY        1000    // extra TX PDU of a notification
+#define ENERGY_NC_FLASH_WRITE   2000    // NVS item write
+#define ENERGY_UA_CPU_ACTIVE    2600    // application core at 64 MHz, cache enabled
+#define ENERGY_UA_IDLE          2       // system on, RTC running, both cores idle
+
+typedef enum {
+  ENERGY_EVT_ADC_CONV = 0,
+  ENERGY_EVT_ADV,
+  ENERGY_EVT_CONN,
+  ENERGY_EVT_NOTIFY,
+  ENERGY_EVT_FLASH_WRITE,
+  ENERGY_EVT_NUM
+}Energy_evt_t;
+
+typedef struct
+{
+  uint32_t  elapsed_ms;
+  uint32_t  cpu_active_ms;
+  uint32_t  events[ENERGY_EVT_NUM];
+  uint64_t  charge_nc[ENERGY_EVT_NUM];
+  uint64_t  cpu_nc;
+  uint64_t  idle_nc;
+  uint32_t  avg_ua;               // total charge / elapsed time
+}Energy_t;
+
+
+/**
+ * @brief Count an event
+ *
+ * For the events not tracked by the other modules (flash writes).
+ *
+ * @param evt event
+ *
+ * @return void
+ */
+void energy_count(Energy_evt_t evt);
+
+/**
+ * @brief Change the cost of an event
+ *
+ * @param evt event
+ * @param nc charge of one event (nC)
+ *
+ * @return void
+ */
+void energy_cost_set(Energy_evt_t evt, uint32_t nc);
+
+/**
+ * @brief Get the energy estimation
+ *
+ * @param energy pointer to the struct to be filled
+ *
+ * @return void
+ */
+void energy_get(Energy_t *energy);
+
+/**
+ * @brief Print the energy estimation
+ *
+ * Average current, charge of each source and active time of each thread.
+ *
+ * no @param
+ *
+ * @return void
+ */
+void energy_report(void);
+
+#endif
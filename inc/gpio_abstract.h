@@ -23,10 +23,25 @@
  * - gpio_enable_interrupt() to enable or disable gpio interrupt for the specific channel
  * - gpio_enable() to enable or disable gpio for the specific channel
  * - get_gpio_pin_interrupt_config() to get the gpio pin interrupt configuration
+ * - get_gpio_label() to get the devicetree label of a channel
  * - gpio_init() to initialize the gpio peripheral starting from device tree information
  * - gpio_configure() to configure the gpio pin for a specific channel
  * - reset_gpio_interrupt() to reset the gpio interrupt status for a specific channel
  * - get_gpio_interrupt_status() to get the gpio interrupt status for a specific channel
+ * - take_gpio_interrupt() to read and reset the gpio interrupt status in one atomic step
+ * - get_gpio_isr_stats() to get the duration statistics of the interrupt dispatcher
+ * - gpio_set_event_handler() to be notified from the ISR when events are posted
+ *
+ * Interrupts are dispatched by one callback per gpio port: the fired pins are mapped to their 
+ * channel with a constant lookup table generated from the devicetree channel list (gpio_dt.h) 
+ * and posted as atomic event bits, so the ISR never scans the gpio array nor logs. Two gpio 
+ * controllers on the same port index fail the build.
+ *
+ * The devicetree configuration of the channels (device, pin, flags, label, interrupt trigger) is a 
+ * constant table in flash, only the enable bits and the error code of each channel are in RAM. 
+ * Channel ids are checked at build time, functions taking a channel don't test it at run time 
+ * (only with CONFIG_ASSERT). A disabled interrupt is disabled in hardware, so reading the events 
+ * needs no enable check.
  * 
  * @author Marconatale Parise
  * @date 09 June 2025
@@ -45,126 +60,174 @@
 #define BTN2_ch        1
 
 
-typedef struct 
-{
-  bool active;
-  uint32_t port_config;
-  bool status;
-}Gpio_int_t;
+typedef void (*Gpio_event_handler_t)(void);
 
+/* Constant configuration of a channel, from devicetree */
 typedef struct
 {
-    bool active;
     const struct device *dev;
+    uint8_t port;
     gpio_pin_t pin;
-    gpio_flags_t flags;
-    uint32_t direction;
-    bool value;
-    Gpio_int_t g_int;
-    uint8_t error;
+    gpio_flags_t flags;         // devicetree flags and direction
+    gpio_flags_t int_config;    // interrupt trigger
     const char *label;
+}Gpio_desc_t;
 
+/* Run time state of a channel */
+typedef struct
+{
+    bool active;
+    bool int_active;
+    bool int_configured;    // set by gpio_configure_interrupt(), an enabled pin is then armed in hardware
+    uint8_t error;
 }Gpio_t;
 
+typedef struct
+{
+    uint32_t count;         // number of dispatcher executions
+    uint32_t pins;          // number of pins dispatched
+    uint32_t max_cycles;    // longest dispatcher execution
+    uint32_t total_cycles;  // sum of all executions, used to get the average
+}Gpio_isr_stats_t;
+
+BUILD_ASSERT(NUM_GPIO_PERIP < UINT8_MAX, "pin lookup table stores channel + 1 in 8 bits");
+BUILD_ASSERT(NUM_GPIO_PERIP <= 32, "gpio events are posted in a 32-bit atomic mask");
+BUILD_ASSERT(BTN1_ch < NUM_GPIO_PERIP && BTN2_ch < NUM_GPIO_PERIP, "gpio channel id out of range");
+
 /**
  * @brief Enable or disable gpio interrupt
  *
- * Enable or disable the gpio interrupt for a specific channel.
+ * Enable or disable the gpio interrupt for a specific channel. Disabling a configured 
+ * interrupt turns it off in hardware and drops its pending event, enabling it again turns 
+ * it back on in hardware (active channel only).
  *
- * @param gt gpio struct pointer to the gpio array
- * @param channel 8-bit value that indicate channel of gpio struct array
+ * @param channel 8-bit value that indicate channel of gpio array
  * @param enable boolean value to enable or disable the interrupt
  *
  * @return void
  */
-void gpio_enable_interrupt(Gpio_t* gt, uint8_t channel, bool enable);
+void gpio_enable_interrupt(uint8_t channel, bool enable);
 
 /**
  * @brief Enable or disable gpio
  *
  * Enable or disable the gpio for a specific channel.
  *
- * @param gt gpio struct pointer to the gpio array
- * @param channel 8-bit value that indicate channel of gpio struct array
+ * @param channel 8-bit value that indicate channel of gpio array
  * @param enable boolean value to enable or disable the gpio
  *
  * @return void
  */
-void gpio_enable(Gpio_t* gt, uint8_t channel, bool enable);
+void gpio_enable(uint8_t channel, bool enable);
 
 /**
  * @brief Get gpio pin interrupt configuration
  *
  * Get the gpio pin interrupt configuration for all active and enabled gpio pins.
  *
- * @param gt gpio struct pointer to the gpio array
- * @param size 8-bit value that indicate number of gpio elements in the array 
+ * no @param
  *
  * @return uint32_t bitmask of active and enabled gpio pins
  */
-uint32_t get_gpio_pin_interrupt_config(Gpio_t* gt, uint8_t size);
+uint32_t get_gpio_pin_interrupt_config(void);
+
+/**
+ * @brief Get gpio label
+ *
+ * @param channel 8-bit value that indicate channel of gpio array
+ *
+ * @return const char* devicetree label of the channel
+ */
+const char *get_gpio_label(uint8_t channel);
 
 /**
  * @brief Initialize gpio peripheral
  *
  * Initialize the gpio peripheral starting from device tree information.
  *
- * @param gt gpio struct pointer to the gpio array
- * @param channel 8-bit value that indicate channel of gpio struct array
- * @param size 8-bit value that indicate number of gpio elements in the array 
+ * @param channel 8-bit value that indicate channel of gpio array
  *
  * @return void
  */
-void gpio_init(Gpio_t* gt, uint8_t channel, uint8_t size);
+void gpio_init(uint8_t channel);
 
 /**
  * @brief Configure gpio pin
  *
  * Configure the gpio pin for a specific channel.
  *
- * @param gt gpio struct pointer to the gpio array
- * @param channel 8-bit value that indicate channel of gpio struct array
- * @param size 8-bit value that indicate number of gpio elements in the array 
+ * @param channel 8-bit value that indicate channel of gpio array
  *
  * @return void
  */
-void gpio_configure(Gpio_t* gt, uint8_t channel, uint8_t size);
+void gpio_configure(uint8_t channel);
 
 /**
  * @brief Configure gpio pin interrupt
  *
  * Configure the gpio pin interrupt for a specific channel.
  *
- * @param gt gpio struct pointer to the gpio array
- * @param channel 8-bit value that indicate channel of gpio struct array
- * @param size 8-bit value that indicate number of gpio elements in the array 
+ * @param channel 8-bit value that indicate channel of gpio array
  *
  * @return void
  */
-void gpio_configure_interrupt(Gpio_t* gt, uint8_t channel, uint8_t size);
+void gpio_configure_interrupt(uint8_t channel);
 
 /**
  * @brief Reset gpio interrupt status
  *
  * Reset the gpio interrupt status for a specific channel.
  *
- * @param gt gpio struct pointer to the gpio array
- * @param channel 8-bit value that indicate channel of gpio struct array
+ * @param channel 8-bit value that indicate channel of gpio array
  *
  * @return void
  */
-void reset_gpio_interrupt(Gpio_t* gt, uint8_t channel);
+void reset_gpio_interrupt(uint8_t channel);
 
 /**
  * @brief Get gpio interrupt status
  *
  * Get the gpio interrupt status for a specific channel.
  *
- * @param gt gpio struct pointer to the gpio array
- * @param channel 8-bit value that indicate channel of gpio struct array
+ * @param channel 8-bit value that indicate channel of gpio array
  *
  * @return bool true if interrupt is active, false otherwise
  */
-bool get_gpio_interrupt_status(Gpio_t* gt, uint8_t channel);
+bool get_gpio_interrupt_status(uint8_t channel);
+
+/**
+ * @brief Take gpio interrupt status
+ *
+ * Read and reset the gpio interrupt status for a specific channel in one atomic step, 
+ * so that an interrupt fired between read and reset is never lost.
+ *
+ * @param channel 8-bit value that indicate channel of gpio array
+ *
+ * @return bool true if interrupt was active, false otherwise
+ */
+bool take_gpio_interrupt(uint8_t channel);
+
+/**
+ * @brief Get gpio interrupt dispatcher statistics
+ *
+ * Copy the duration statistics of the gpio interrupt dispatcher.
+ *
+ * @param stats pointer to the struct to be filled
+ *
+ * @return void
+ */
+void get_gpio_isr_stats(Gpio_isr_stats_t *stats);
+
+/**
+ * @brief Set gpio event handler
+ *
+ * The handler is called in interrupt context after the events of a dispatch are posted, 
+ * it should only wake up the consumer of the events (take_gpio_interrupt()).
+ *
+ * @param handler event handler, NULL to poll the events
+ *
+ * @return void
+ */
+void gpio_set_event_handler(Gpio_event_handler_t handler);
 
-#endif
\ No newline at end of file
+#endif
@@ -38,34 +38,40 @@
 #define BTN1_NODE          DT_ALIAS(sw0)
 #define BTN2_NODE          DT_ALIAS(sw1)
 
-// /* The devicetree node identifier for the "button 1" alias. */
-#if DT_NODE_HAS_STATUS(BTN1_NODE, okay)
-#define PIN_BTN1      DT_GPIO_PIN(BTN1_NODE, gpios)
-#define FLAGS_BTN1     DT_GPIO_FLAGS(BTN1_NODE, gpios)
-#define LABEL_BTN1     DT_PROP(BTN1_NODE, label)
-#else
+#if !DT_NODE_HAS_STATUS(BTN1_NODE, okay)
 #error "Unsupported board: button 1 devicetree alias is not defined"
-#define DEV_BTN1	    ""
-#define PIN_BTN1	0
-#define FLAGS_BTN1	0
-#define LABEL_BTN1    ""
 #endif
 
-// /* The devicetree node identifier for the "button 1" alias. */
-#if DT_NODE_HAS_STATUS(BTN2_NODE, okay)
-#define PIN_BTN2      DT_GPIO_PIN(BTN2_NODE, gpios)
-#define FLAGS_BTN2     DT_GPIO_FLAGS(BTN2_NODE, gpios)
-#define LABEL_BTN2     DT_PROP(BTN2_NODE, label)
-#else
-#error "Unsupported board: button 1 devicetree alias is not defined"
-#define DEV_BTN2	    ""
-#define PIN_BTN2	0
-#define FLAGS_BTN2	0
-#define LABEL_BTN2    ""
+#if !DT_NODE_HAS_STATUS(BTN2_NODE, okay)
+#error "Unsupported board: button 2 devicetree alias is not defined"
 #endif
 
+/* gpio channels: channel id (gpio_abstract.h) and devicetree node. The channel descriptors, 
+ * the pin lookup table and the port checks of gpio_abstract.c are generated from this list */
+#define GPIO_DT_CHANNELS(fn, ...)             \
+  fn(BTN1_ch, BTN1_NODE, __VA_ARGS__)   \
+  fn(BTN2_ch, BTN2_NODE, __VA_ARGS__)
+
+/* port index of the gpio controller, controllers without "port" property are port 0: 
+ * two controllers on the same index fail the build (gpio_abstract.c) */
+#define GPIO_DT_PORT(node)      DT_PROP_OR(DT_GPIO_CTLR(node, gpios), port, 0)
+#define GPIO_DT_CTLR_ORD(node)  DT_DEP_ORD(DT_GPIO_CTLR(node, gpios))
+#define GPIO_DT_NGPIOS(node)    DT_PROP_OR(DT_GPIO_CTLR(node, gpios), ngpios, GPIO_DT_MAX_PINS)
+
+/* pin masks are 32 bits: upper bound of the pins of a port and of the port indexes */
+#define GPIO_DT_MAX_PINS        32
 
+/* maximum of get(node) over the channels, as a constant expression: the count of the k in 
+ * [0, GPIO_DT_MAX_PINS) that are below the value of at least one channel */
+#define GPIO_DT_ANY_ABOVE(ch, node, k, get)   || (get(node) > (k))
+#define GPIO_DT_COUNT_BELOW(k, get)           + (0 GPIO_DT_CHANNELS(GPIO_DT_ANY_ABOVE, k, get))
+#define GPIO_DT_MAX(get)                      (0 LISTIFY(GPIO_DT_MAX_PINS, GPIO_DT_COUNT_BELOW, (), get))
 
+#define GPIO_DT_PORT_NUM(node)  (GPIO_DT_PORT(node) + 1)
 
+/* number of gpio ports (highest port index + 1) and pins handled by each port (highest ngpios 
+ * of the controllers), both from devicetree */
+#define GPIO_NUM_PORTS          GPIO_DT_MAX(GPIO_DT_PORT_NUM)
+#define GPIO_PINS_PER_PORT      GPIO_DT_MAX(GPIO_DT_NGPIOS)
 
 #endif
\ No newline at end of file
@@ -0,0 +1,165 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file hr_agg.h
+ * @brief this file handles the windowed aggregation of the heart rate: every usable heart rate 
+ * value of the DSP stage updates the statistics of the current window, one summary record 
+ * is sent per window on the trend service (bt_trend.h) instead of the single values.
+ *
+ * Sampling is adaptive: a moving signal is sampled every few tens of ms, a stable one every 
+ * few seconds. Each value is weighted by its sampling period (the time it stands for until 
+ * the next sample), so the mean and the percentiles are over time, not over samples, and 
+ * active periods are not over-represented.
+ *
+ * Per sample the update is O(1): count, weighted sum, min, max and one counter of a 
+ * fixed-size histogram (HR_AGG_BUCKETS buckets of HR_AGG_BUCKET_BPM, ms per bucket). 
+ * Percentiles are read from the histogram when the window closes, the value is the middle 
+ * of the bucket clamped to the window min/max, so the error is at most HR_AGG_BUCKET_BPM / 2.
+ *
+ * Windows are closed by the TASK_SUMMARY task every CONFIG_APP_HR_AGG_WINDOW_MS, the length 
+ * can be changed at run time. Sampling and window close both run on the processing workqueue.
+ *
+ * The following functions will be implemented:
+ * - hr_agg_add() : Add a heart rate value to the current window.
+ * - hr_agg_skip() : Count a value not added (signal not usable).
+ * - hr_agg_close() : Close the current window and get its summary.
+ * - hr_agg_window_set() : Change the window length.
+ * - hr_agg_window_get() : Get the window length.
+ * - hr_agg_get_last() : Get the summary of the last closed window.
+ * - hr_agg_get_stats() : Get windows, samples and cost per sample.
+ * - hr_agg_report() : Print the statistics and the last window summary.
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+
+#ifndef __HR_AGG_H__
+#define __HR_AGG_H__
+
+#include <zephyr/kernel.h>
+#include "common.h"
+
+#define HR_AGG_MIN_BPM        30    // first bucket, lower values go in it
+#define HR_AGG_BUCKET_BPM     2
+#define HR_AGG_BUCKETS        96    // 30..222 bpm, higher values go in the last bucket
+#define HR_AGG_WINDOW_MIN_MS  1000
+#define HR_AGG_WINDOW_MAX_MS  3600000   // window_s of the summary in 16 bits
+
+typedef struct
+{
+  uint16_t  seq;          // window number, a gap means windows without samples
+  uint16_t  window_s;     // window length
+  uint16_t  count;        // samples in the window, saturated at UINT16_MAX
+  uint8_t   min;          // bpm
+  uint8_t   max;
+  uint16_t  mean_x10;     // time weighted mean, 0.1 bpm
+  uint8_t   p10;          // time weighted percentiles from the histogram, bpm
+  uint8_t   p50;
+  uint8_t   p90;
+}Hr_agg_summary_t;
+
+typedef struct
+{
+  uint32_t  windows;        // windows closed with samples
+  uint32_t  samples;        // values added
+  uint32_t  skipped;        // values not added, signal not usable
+  uint32_t  cycles_total;   // cpu cycles spent in hr_agg_add()
+  uint32_t  cycles_max;
+}Hr_agg_stats_t;
+
+
+/**
+ * @brief Add a heart rate value
+ *
+ * @param bpm heart rate
+ * @param weight_ms sampling period of the value, clamped to the window length
+ *
+ * @return void
+ */
+void hr_agg_add(uint8_t bpm, uint32_t weight_ms);
+
+/**
+ * @brief Count a value not added
+ *
+ * no @param
+ *
+ * @return void
+ */
+void hr_agg_skip(void);
+
+/**
+ * @brief Close the current window
+ *
+ * The statistics are reset for the next window.
+ *
+ * @param summary pointer to the struct to be filled
+ *
+ * @return bool true if the window had samples (summary filled), false otherwise
+ */
+bool hr_agg_close(Hr_agg_summary_t *summary);
+
+/**
+ * @brief Change the window length
+ *
+ * The current window is kept, the new length applies from the next close.
+ *
+ * @param window_ms HR_AGG_WINDOW_MIN_MS..HR_AGG_WINDOW_MAX_MS
+ *
+ * @return 0 on success, -EINVAL if out of range
+ */
+int hr_agg_window_set(uint32_t window_ms);
+
+/**
+ * @brief Get the window length
+ *
+ * no @param
+ *
+ * @return uint32_t window length in ms
+ */
+uint32_t hr_agg_window_get(void);
+
+/**
+ * @brief Get the last summary
+ *
+ * @param summary pointer to the struct to be filled
+ *
+ * @return bool false if no window has been closed with samples yet
+ */
+bool hr_agg_get_last(Hr_agg_summary_t *summary);
+
+/**
+ * @brief Get aggregation statistics
+ *
+ * @param stats pointer to the struct to be filled
+ *
+ * @return void
+ */
+void hr_agg_get_stats(Hr_agg_stats_t *stats);
+
+/**
+ * @brief Print aggregation statistics
+ *
+ * Windows, samples and cost per sample, then the summary of the last closed window.
+ *
+ * no @param
+ *
+ * @return void
+ */
+void hr_agg_report(void);
+
+#endif
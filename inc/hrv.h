@@ -0,0 +1,134 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file hrv.h
+ * @brief this file handles the streaming heart rate variability metrics over a sliding window 
+ * of the last HRV_WINDOW_BEATS RR intervals:
+ * - SDNN, standard deviation of the RR intervals (Welford's method, add and replace),
+ * - RMSSD, root mean square of the successive differences,
+ * - pNN50, share of successive differences larger than 50 ms.
+ *
+ * Each RR interval updates running sums in constant time and memory with integer arithmetic 
+ * (mean and sum of squared deviations in Q16): the interval leaving the window is removed 
+ * from the sums instead of rescanning the window. Square roots are only taken when the 
+ * metrics are read.
+ *
+ * Beats are not detected on this board: the RR interval is derived from each new heart rate 
+ * value of the HR_CH processing path (60000 / bpm), one per adaptive sampling round. The series 
+ * is synthetic, its metrics follow the variability of the averaged heart rate estimate and 
+ * the sampling period, not the real beat to beat variability: the module and its trend 
+ * characteristic are only built with CONFIG_APP_HRV (off by default). hrv_add_rr() takes real 
+ * RR intervals once a beat detector is available. Intervals out of HRV_RR_MIN_MS..HRV_RR_MAX_MS 
+ * are rejected. tests/hrv checks the metrics against a reference computed over the window.
+ *
+ * The following functions will be implemented:
+ * - hrv_add_rr() : Add an RR interval to the window.
+ * - hrv_add_bpm() : Add the RR interval of a heart rate value.
+ * - hrv_reset() : Empty the window.
+ * - hrv_get() : Get the metrics of the window.
+ * - hrv_get_stats() : Get beats, rejects and cost per beat.
+ * - hrv_report() : Print the statistics and the metrics of the window.
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+
+#ifndef __HRV_H__
+#define __HRV_H__
+
+#include <zephyr/kernel.h>
+#include "common.h"
+
+#define HRV_WINDOW_BEATS  64      // RR intervals of the sliding window
+#define HRV_RR_MIN_MS     300     // 200 bpm
+#define HRV_RR_MAX_MS     2000    // 30 bpm
+#define HRV_NN50_MS       50
+
+typedef struct
+{
+  uint16_t  beats;        // RR intervals in the window
+  uint16_t  mean_rr_ms;
+  uint16_t  sdnn_x10;     // 0.1 ms
+  uint16_t  rmssd_x10;    // 0.1 ms
+  uint16_t  pnn50_x10;    // 0.1 %
+}Hrv_metrics_t;
+
+typedef struct
+{
+  uint32_t  beats;          // RR intervals added
+  uint32_t  rejected;       // RR intervals out of range
+  uint32_t  cycles_total;   // cpu cycles spent in hrv_add_rr()
+  uint32_t  cycles_max;
+}Hrv_stats_t;
+
+
+/**
+ * @brief Add an RR interval
+ *
+ * @param rr_ms RR interval in ms
+ *
+ * @return void
+ */
+void hrv_add_rr(uint16_t rr_ms);
+
+/**
+ * @brief Add the RR interval of a heart rate value
+ *
+ * @param bpm heart rate, 0 is ignored
+ *
+ * @return void
+ */
+void hrv_add_bpm(uint8_t bpm);
+
+/**
+ * @brief Empty the window
+ *
+ * no @param
+ *
+ * @return void
+ */
+void hrv_reset(void);
+
+/**
+ * @brief Get the metrics of the window
+ *
+ * @param metrics pointer to the struct to be filled
+ *
+ * @return bool false if the window has less than 2 RR intervals (metrics are zero)
+ */
+bool hrv_get(Hrv_metrics_t *metrics);
+
+/**
+ * @brief Get HRV statistics
+ *
+ * @param stats pointer to the struct to be filled
+ *
+ * @return void
+ */
+void hrv_get_stats(Hrv_stats_t *stats);
+
+/**
+ * @brief Print HRV statistics
+ *
+ * no @param
+ *
+ * @return void
+ */
+void hrv_report(void);
+
+#endif
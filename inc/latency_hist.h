@@ -0,0 +1,103 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file latency_hist.h
+ * @brief this file handles the sample-to-air latency histograms: age of the heart rate 
+ * measurement, from the adc conversion complete, when its notification is queued and when 
+ * the notification is sent.
+ *
+ * Buckets are powers of two of ms: bucket 0 counts latencies below 1 ms, bucket i latencies 
+ * in [2^(i-1), 2^i) ms, the last bucket everything above. Samples are added from the bluetooth 
+ * TX callbacks and the processing workqueue while the GATT diagnostics and the shell read or 
+ * clear the histograms, so every access takes a spinlock and readers get a consistent copy.
+ *
+ * The following functions will be implemented:
+ * - latency_hist_add() : Add a latency sample to the histogram of a stage.
+ * - latency_hist_get() : Get a copy of the histogram of a stage.
+ * - latency_hist_reset() : Clear all histograms.
+ * - latency_hist_report() : Print all histograms.
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+
+#ifndef __LATENCY_HIST_H__
+#define __LATENCY_HIST_H__
+
+#include <zephyr/kernel.h>
+#include "common.h"
+
+#define LAT_BUCKETS 16  // last bucket starts at 2^14 ms = 16.4 s
+
+typedef enum {
+  LAT_STAGE_QUEUED = 0, // adc complete -> notification queued
+  LAT_STAGE_SENT,       // adc complete -> notification sent
+  LAT_STAGE_NUM
+}Lat_stage_t;
+
+typedef struct
+{
+  uint32_t  count;
+  uint32_t  max_ms;
+  uint32_t  sum_ms;
+  uint32_t  buckets[LAT_BUCKETS];
+}Latency_hist_t;
+
+
+/**
+ * @brief Add a latency sample
+ *
+ * @param stage histogram to be updated
+ * @param sample_cyc cycle counter at adc conversion complete
+ * @param now_cyc cycle counter at the end of the stage
+ *
+ * @return void
+ */
+void latency_hist_add(Lat_stage_t stage, uint32_t sample_cyc, uint32_t now_cyc);
+
+/**
+ * @brief Get a histogram
+ *
+ * @param stage histogram to be copied
+ * @param hist pointer to the struct to be filled
+ *
+ * @return void
+ */
+void latency_hist_get(Lat_stage_t stage, Latency_hist_t *hist);
+
+/**
+ * @brief Clear all histograms
+ *
+ * no @param
+ *
+ * @return void
+ */
+void latency_hist_reset(void);
+
+/**
+ * @brief Print all histograms
+ *
+ * Print count, mean and max of each stage and its non empty buckets.
+ *
+ * no @param
+ *
+ * @return void
+ */
+void latency_hist_report(void);
+
+#endif
@@ -0,0 +1,151 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file meas_rec.h
+ * @brief this file handles the measurement records shared by the consumers (bluetooth, 
+ * diagnostics, storage).
+ *
+ * Each processing round fills a fixed-size record allocated from a memory slab and publishes
+ * it as the latest measurement. Consumers take a reference to the latest record, read it in 
+ * place and release it: the record goes back to the slab when the last reference is dropped.
+ * The latest record keeps one reference until the next one is published.
+ *
+ * With MEAS_REC_ZERO_COPY set to 0 every consumer gets its own copy of the measurement 
+ * (meas_rec_read()), as with the former global struct: the bytes copied per measurement of 
+ * both builds are printed in the report.
+ *
+ * The following functions will be implemented:
+ * - meas_rec_alloc() : Allocate a record for the processing round.
+ * - meas_rec_publish() : Publish a record as the latest measurement.
+ * - meas_rec_get_latest() : Take a reference to the latest measurement.
+ * - meas_rec_unref() : Release a reference.
+ * - meas_rec_read() : Copy the latest measurement.
+ * - meas_rec_get_stats() : Get allocation and copy counters.
+ * - meas_rec_report() : Print allocation and copy counters.
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+
+#ifndef __MEAS_REC_H__
+#define __MEAS_REC_H__
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include "common.h"
+
+#define MEAS_REC_ZERO_COPY  1   // 0: consumers copy the measurement, bytes copied baseline
+/* Latest + round in progress: producer and consumers all run on proc_wq and a consumer drops 
+ * its reference within its task, staged notifications keep an encoded copy, not a record */
+#define MEAS_REC_COUNT      2
+
+typedef struct
+{
+    float adc_batt_mV;
+    uint8_t bt_batt_lvl;
+    float adc_heart_rate_mV;
+    uint8_t bt_heart_rate;
+    uint32_t hr_sample_cyc;   // adc conversion timestamp of the newest sample in bt_heart_rate
+}Perip_t;
+
+typedef struct
+{
+  atomic_t  refs;
+  uint32_t  seq;              // processing round that filled the record
+  Perip_t   meas;
+}Meas_rec_t;
+
+typedef struct
+{
+  uint32_t  published;
+  uint32_t  alloc_failures;   // rounds dropped, consumers keep the previous record
+  uint32_t  in_use;
+  uint32_t  max_in_use;       // slab watermark
+  uint32_t  bytes_copied;     // measurement bytes copied to the consumers
+}Meas_rec_stats_t;
+
+
+/**
+ * @brief Allocate a record
+ *
+ * The record is returned with one reference, owned by the caller until it is published.
+ *
+ * no @param
+ *
+ * @return Meas_rec_t* record, NULL if the slab is exhausted
+ */
+Meas_rec_t *meas_rec_alloc(void);
+
+/**
+ * @brief Publish a record
+ *
+ * The reference of the caller moves to the latest measurement, the previous latest 
+ * record is released.
+ *
+ * @param rec record filled by the processing round
+ *
+ * @return void
+ */
+void meas_rec_publish(Meas_rec_t *rec);
+
+/**
+ * @brief Take a reference to the latest measurement
+ *
+ * no @param
+ *
+ * @return Meas_rec_t* record to be released with meas_rec_unref(), NULL if nothing published
+ */
+Meas_rec_t *meas_rec_get_latest(void);
+
+/**
+ * @brief Release a reference
+ *
+ * @param rec record, freed when its last reference is dropped
+ *
+ * @return void
+ */
+void meas_rec_unref(Meas_rec_t *rec);
+
+/**
+ * @brief Copy the latest measurement
+ *
+ * @param meas pointer to the struct to be filled
+ *
+ * @return int 0 on success, -ENODATA if nothing published
+ */
+int meas_rec_read(Perip_t *meas);
+
+/**
+ * @brief Get record statistics
+ *
+ * @param stats pointer to the struct to be filled
+ *
+ * @return void
+ */
+void meas_rec_get_stats(Meas_rec_stats_t *stats);
+
+/**
+ * @brief Print record statistics
+ *
+ * no @param
+ *
+ * @return void
+ */
+void meas_rec_report(void);
+
+#endif
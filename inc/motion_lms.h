@@ -0,0 +1,91 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file motion_lms.h
+ * @brief this file handles the motion artifact canceller of the heart rate channel: an adaptive 
+ * normalized LMS filter in fixed point, with the accelerometer as reference input.
+ *
+ * The filter estimates the part of the heart rate signal (minus its mean) that is correlated 
+ * with the last MOTION_LMS_TAPS motion reference samples and subtracts it. The filter is 
+ * installed with adc_filter_set(), so it runs on each sample before the glitch check and 
+ * the average. When no aligned motion samples are available the sample is passed through.
+ *
+ * The following functions will be implemented:
+ * - motion_lms_filter() : Cancel the motion artifact from a heart rate sample.
+ * - motion_lms_get_stats() : Get filtered/bypassed samples and cpu cost.
+ * - motion_lms_report() : Print the canceller statistics.
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+
+#ifndef __MOTION_LMS_H__
+#define __MOTION_LMS_H__
+
+#include "common.h"
+#include "adc_abstract.h"
+#include "accel_fifo.h"
+
+#define MOTION_LMS_TAPS       4
+#define MOTION_LMS_MU_Q15     3277  // step size 0.1
+#define MOTION_LMS_EPS        16    // regularization of the reference power, mg^2
+#define MOTION_LMS_MAX_SKEW_MS 100  // newest motion sample must be at most this old
+
+typedef struct
+{
+  uint32_t  samples;      // samples filtered
+  uint32_t  bypassed;     // samples passed through, motion reference not aligned
+  uint32_t  cycles_total; // cpu cycles spent filtering
+  uint16_t  removed_q4;   // mean absolute artifact removed, mV in Q4
+}Motion_lms_stats_t;
+
+
+/**
+ * @brief Cancel motion artifact
+ *
+ * adc_filter_t of the heart rate channel.
+ *
+ * @param sample heart rate sample in mV
+ * @param ts_cyc conversion timestamp in cycles
+ *
+ * @return adc_sample_t sample with the motion correlated component removed
+ */
+adc_sample_t motion_lms_filter(adc_sample_t sample, uint32_t ts_cyc);
+
+/**
+ * @brief Get canceller statistics
+ *
+ * @param stats pointer to the struct to be filled
+ *
+ * @return void
+ */
+void motion_lms_get_stats(Motion_lms_stats_t *stats);
+
+/**
+ * @brief Print canceller statistics
+ *
+ * Filtered and bypassed samples, cycles per sample and mean artifact removed.
+ * Nothing is printed without an accelerometer.
+ *
+ * no @param
+ *
+ * @return void
+ */
+void motion_lms_report(void);
+
+#endif
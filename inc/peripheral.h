@@ -28,26 +28,36 @@
 #include "common.h"
 #include "gpio_abstract.h"
 #include "bt_abstract.h"
+#include "bt_adv.h"
 #include "adc_abstract.h"
-
-typedef struct
-{
-    float adc_batt_mV;
-    uint8_t bt_batt_lvl;
-    float adc_heart_rate_mV;
-    uint8_t bt_heart_rate;
-}Perip_t;
+#include "proc_wq.h"
+#include "accel_fifo.h"
+#include "motion_lms.h"
+#include "meas_rec.h"
+#include "energy.h"
+#include "app_cfg.h"
+#include "hr_agg.h"
+#include "hrv.h"
+#include "bt_trend.h"
+#include "bt_sync.h"
+#if defined(CONFIG_ADC_EMUL)
+#include "adc_replay.h"
+#endif
 
 #define HR_MIN_VALUE 60.0F
 #define HR_MAX_VALUE 160.0F
 #define BATT_MIN_PERC_VALUE 0.0F
 #define BATT_MAX_PERC_VALUE 100.0F
 
+#define REPORT_PERIOD_MS  60000   // period of the report task
+
 
 /**
  * @brief Initialize peripherals
  *
  * Initialize peripherals to asserve the functionalities of the system. 
+ * Bluetooth is enabled asynchronously first, so gpio and adc setup overlaps the network core boot;
+ * use bt_wait_ready() before using bluetooth services.
  *
  * NO parameters are required for this function.
  *
@@ -77,9 +87,77 @@ bool is_button1_pressed();
  */
 bool is_button2_pressed();
 
-void bt_bas_set(void);
-void bt_hrs_set(void);
-void set_heart_rate_value(void);
-void set_battery_perc(void);
+/* Stage battery level / heart rate of the latest measurement, skipped when the channel signal 
+ * quality is not usable */
+bool bt_bas_stage(void);
+bool bt_hrs_stage(void);
+/* Close the heart rate aggregation window and stage its summary, with the HRV metrics */
+bool bt_summary_stage(void);
+/* Send the staged values: a single multiple handle notification for capable peers */
+void bt_staged_flush(void);
+/**
+ * @brief Acquire a channel
+ *
+ * Acquisition stage: convert the channel, the result is queued in the adc sample ring.
+ *
+ * @param channel 8-bit value that indicate channel of adc abstract array 
+ *
+ * @return void
+ */
+void perip_acquire(uint8_t channel);
+
+/**
+ * @brief Process acquired samples
+ *
+ * Drain the adc sample ring and update glitch filter and average of each channel.
+ *
+ * No parameters are required for this function.
+ *
+ * @return uint32_t number of samples processed
+ */
+uint32_t perip_process(void);
+
+/**
+ * @brief Start motion reference acquisition
+ *
+ * When the accelerometer is available, start draining its FIFO on the processing workqueue.
+ *
+ * @param queue processing workqueue
+ *
+ * @return void
+ */
+void perip_motion_start(struct k_work_q *queue);
+
+/**
+ * @brief Publish a measurement
+ *
+ * DSP stage: fill a measurement record with heart rate and battery level of the averaged 
+ * channel voltages and publish it to the consumers. The round is dropped when no record 
+ * is free. A new heart rate value goes to the aggregation window (hr_agg.h) and, as an RR 
+ * interval, to the HRV window (hrv.h) if usable.
+ *
+ * @param due_mask channels sampled in the round
+ *
+ * @return void
+ */
+void perip_measure(uint8_t due_mask);
+
+/* DSP stage: convert the averaged channel voltage to heart rate / battery level */
+void set_heart_rate_value(Perip_t *meas);
+void set_battery_perc(Perip_t *meas);
+
+/**
+ * @brief Print the cost per call and the last measurement
+ *
+ * The COST line gives the cycles per adc conversion, per gpio dispatch and per notification,
+ * the bytes copied per notification and the processing time spent in the radio windows; it is
+ * parsed by bench/bsim/bench_report.py. The other modules print their own report 
+ * (adc_report(), hr_agg_report(), ...), all called by the report task every REPORT_PERIOD_MS.
+ *
+ * No parameters are required for this function.
+ *
+ * @return void
+ */
+void perip_report(void);
 
 #endif /* __PERIPHERAL_H__ */
\ No newline at end of file
@@ -0,0 +1,113 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file proc_wq.h
+ * @brief this file handles the processing workqueue: acquisition and DSP stages run as work items
+ * of a dedicated workqueue scheduled with deadlines (CONFIG_SCHED_DEADLINE).
+ *
+ * The workqueue also runs the application task scheduler (task_sched.h): the acquisition stage 
+ * is its sampling task, notifications and buttons are the other tasks.
+ * Each sampling round is released when the first adc channel is due. The workqueue thread gets 
+ * a deadline equal to the sample period of the round, so among the threads of the same priority 
+ * the EDF scheduler runs first the one closer to its deadline.
+ * A round that completes the DSP stage after its deadline is counted as a miss.
+ * The time spent by the DSP stage and by each scheduler wakeup is given to bt_sync.h, which 
+ * measures its overlap with the connection events.
+ *
+ * The following functions will be implemented:
+ * - proc_wq_start() : Start the workqueue and the first sampling round.
+ * - proc_wq_sample_now() : Run acquisition and DSP of some channels at once.
+ * - proc_wq_get_stats() : Get rounds, deadline misses and worst latency.
+ * - proc_wq_report() : Print the workqueue and task scheduler statistics.
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+
+#ifndef __PROC_WQ_H__
+#define __PROC_WQ_H__
+
+#include <zephyr/kernel.h>
+#include "common.h"
+#include "task_sched.h"
+
+#define PROC_WQ_PRIORITY      7   // same priority of the load test thread, so that deadlines decide the order
+#define PROC_WQ_USE_DEADLINE  1   // 0 to compare with plain priority scheduling
+
+/* Load test (CONFIG_APP_PROC_LOAD_TEST): a thread with the same priority floods the console, 
+ * keeps the cpu busy and sends the notifications through the grouped path. The bluetooth tasks 
+ * run on proc_wq as well, so the deadlines order the load thread against the whole processing 
+ * round (sampling, DSP and bluetooth), not bluetooth against DSP */
+#define PROC_LOAD_PERIOD_MS   20
+#define PROC_LOAD_BUSY_MS     8
+#define PROC_LOAD_STACK_SIZE  1024
+
+typedef struct
+{
+  uint32_t rounds;          // sampling rounds completed
+  uint32_t misses;          // rounds completed after their deadline
+  uint32_t max_latency_us;  // worst time from release to end of the DSP stage
+}Proc_stats_t;
+
+
+/**
+ * @brief Start processing workqueue
+ *
+ * Start the workqueue thread and the task scheduler, and schedule the first sampling round. 
+ * To be called after peripheral_init(), before registering the other tasks.
+ *
+ * no @param
+ *
+ * @return void
+ */
+void proc_wq_start(void);
+
+/**
+ * @brief Sample channels now
+ *
+ * Acquisition and DSP stages of the channels in the current work item, so the measurement is 
+ * published when it returns. A pending round does not process them again. To be called from 
+ * a task of the scheduler.
+ *
+ * @param mask channels to be sampled
+ *
+ * @return void
+ */
+void proc_wq_sample_now(uint8_t mask);
+
+/**
+ * @brief Get processing statistics
+ *
+ * @param stats pointer to the struct to be filled
+ *
+ * @return void
+ */
+void proc_wq_get_stats(Proc_stats_t *stats);
+
+/**
+ * @brief Print processing statistics
+ *
+ * Print rounds, deadline misses (with miss rate) and worst latency.
+ *
+ * no @param
+ *
+ * @return void
+ */
+void proc_wq_report(void);
+
+#endif
@@ -0,0 +1,100 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file spsc_ring.h
+ * @brief this file contains a lock-free single producer / single consumer ring of raw adc samples,
+ * used to move samples from the adc completion callback (ISR) to the processing workqueue.
+ *
+ * Only the producer writes head and only the consumer writes tail, so no lock is needed: 
+ * the producer publishes a slot by storing head after the slot is written, the consumer 
+ * releases slots by storing tail after they are read. Head and tail live in separate 
+ * cache lines so the two sides never share a line. When the ring is full the new sample 
+ * is dropped and counted as overrun.
+ *
+ * The following functions will be implemented:
+ * - spsc_ring_push() : Producer side, add one sample.
+ * - spsc_ring_pop_batch() : Consumer side, remove up to n samples.
+ * - spsc_ring_count() : Number of samples waiting in the ring.
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+
+#ifndef __SPSC_RING_H__
+#define __SPSC_RING_H__
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include "common.h"
+
+#define SPSC_RING_CAPACITY  32  // must be a power of two
+#define SPSC_CACHE_LINE     32
+
+BUILD_ASSERT(IS_POWER_OF_TWO(SPSC_RING_CAPACITY), "ring capacity must be a power of two");
+
+typedef struct
+{
+  uint32_t ts_cyc;    // cycle counter at adc completion
+  int16_t  raw;       // raw conversion result
+  uint8_t  channel;
+}Adc_raw_sample_t;
+
+typedef struct
+{
+  atomic_t head __aligned(SPSC_CACHE_LINE);  // next slot to write, producer only
+  uint32_t overruns;                          // samples dropped because the ring was full
+  atomic_t tail __aligned(SPSC_CACHE_LINE);  // next slot to read, consumer only
+  Adc_raw_sample_t slots[SPSC_RING_CAPACITY] __aligned(SPSC_CACHE_LINE);
+}Spsc_ring_t;
+
+
+/**
+ * @brief Push a sample
+ *
+ * Producer side, safe to call from ISR.
+ *
+ * @param ring pointer to the ring
+ * @param sample pointer to the sample to be copied in the ring
+ *
+ * @return bool true if the sample is stored, false if the ring is full (overrun counted)
+ */
+bool spsc_ring_push(Spsc_ring_t *ring, const Adc_raw_sample_t *sample);
+
+/**
+ * @brief Pop a batch of samples
+ *
+ * Consumer side, copy up to max samples in arrival order.
+ *
+ * @param ring pointer to the ring
+ * @param out array to be filled
+ * @param max number of elements of out
+ *
+ * @return uint32_t number of samples copied
+ */
+uint32_t spsc_ring_pop_batch(Spsc_ring_t *ring, Adc_raw_sample_t *out, uint32_t max);
+
+/**
+ * @brief Count waiting samples
+ *
+ * @param ring pointer to the ring
+ *
+ * @return uint32_t number of samples written and not read yet
+ */
+uint32_t spsc_ring_count(Spsc_ring_t *ring);
+
+#endif
@@ -0,0 +1,171 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file task_sched.h
+ * @brief this file handles the application tasks: sampling, notifications, battery level and 
+ * buttons run on the processing workqueue from a single delayable work item.
+ *
+ * Periodic tasks are due at start + phase + k * period, so tasks with aligned periods are due 
+ * at the same time and run in the same wakeup. A task may also run up to slack_ms before its 
+ * due time to share the wakeup of another task. One-shot tasks (period 0) are armed with 
+ * task_sched_run_in() (sampling rounds, adaptive period) or posted from an ISR with 
+ * task_sched_post() (buttons). After the tasks of a wakeup the tick hook runs once, so that 
+ * values staged by several tasks are sent in one notification flush.
+ *
+ * A periodic task started one period or more after its due time counts an overrun, the 
+ * missed periods are skipped.
+ *
+ * The following functions will be implemented:
+ * - task_sched_start() : Start the scheduler on a workqueue.
+ * - task_sched_add() : Register a task.
+ * - task_sched_run_in() : Arm a one-shot task.
+ * - task_sched_post() : Run a one-shot task as soon as possible, from ISR.
+ * - task_sched_set_period() : Change the period of a periodic task.
+ * - task_sched_get_stats() : Get the statistics of a task.
+ * - task_sched_wakeup_cyc() : Get the start of the current wakeup.
+ * - task_sched_report() : Print wakeups and task statistics.
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+
+#ifndef __TASK_SCHED_H__
+#define __TASK_SCHED_H__
+
+#include <zephyr/kernel.h>
+#include "common.h"
+
+#define TASK_SLACK_MS   100   // notification tasks may run this much early to share a wakeup
+
+typedef void (*Task_fn_t)(void);
+
+typedef enum {
+  TASK_SAMPLE = 0,      // sampling round, armed by the DSP stage
+  TASK_NOTIFY,          // heart rate notification
+  TASK_BATTERY,         // battery level notification
+  TASK_BUTTONS,         // button events, posted by the gpio ISR
+  TASK_SUMMARY,         // heart rate window summary
+  TASK_CONFIG,          // run time parameters update, posted by app_cfg_set()
+  TASK_SYNC,            // heart rate sampled and staged before a connection event (CONFIG_APP_BT_SYNC)
+  TASK_REPORT,          // statistics of every module, every REPORT_PERIOD_MS
+  TASK_NUM
+}Task_id_t;
+
+typedef struct
+{
+  uint32_t  runs;
+  uint32_t  coalesced;      // runs in the wakeup of another task
+  uint32_t  overruns;       // runs started one period or more late
+  uint32_t  max_late_ms;
+  uint32_t  cycles_total;
+  uint32_t  cycles_max;
+}Task_stats_t;
+
+
+/**
+ * @brief Start the scheduler
+ *
+ * @param queue workqueue running the tasks
+ * @param tick_hook called once after the tasks of each wakeup, can be NULL
+ *
+ * @return void
+ */
+void task_sched_start(struct k_work_q *queue, Task_fn_t tick_hook);
+
+/**
+ * @brief Register a task
+ *
+ * @param id task
+ * @param name name printed in the report
+ * @param fn task function
+ * @param period_ms period, 0 for a one-shot task
+ * @param phase_ms offset of the periodic due times from the scheduler start
+ * @param slack_ms how early the task may run to share a wakeup
+ *
+ * @return void
+ */
+void task_sched_add(Task_id_t id, const char *name, Task_fn_t fn, uint32_t period_ms, uint32_t phase_ms,
+                    uint32_t slack_ms);
+
+/**
+ * @brief Arm a one-shot task
+ *
+ * @param id task
+ * @param delay_ms delay from now
+ *
+ * @return void
+ */
+void task_sched_run_in(Task_id_t id, uint32_t delay_ms);
+
+/**
+ * @brief Post a one-shot task
+ *
+ * The task runs in the next wakeup of the scheduler, which is requested now. ISR safe.
+ *
+ * @param id task
+ *
+ * @return void
+ */
+void task_sched_post(Task_id_t id);
+
+/**
+ * @brief Change the period of a periodic task
+ *
+ * The next due time moves to the new grid (scheduler start + phase + k * period), so a 
+ * shorter period takes effect at once. Setting it on a task not registered yet has no effect.
+ *
+ * @param id task
+ * @param period_ms new period, not 0
+ *
+ * @return void
+ */
+void task_sched_set_period(Task_id_t id, uint32_t period_ms);
+
+/**
+ * @brief Get the start of the current wakeup
+ *
+ * For the tick hook, to measure the time spent in the wakeup.
+ *
+ * no @param
+ *
+ * @return uint32_t cycle counter at the start of the wakeup
+ */
+uint32_t task_sched_wakeup_cyc(void);
+
+/**
+ * @brief Get task statistics
+ *
+ * @param id task
+ * @param stats pointer to the struct to be filled
+ *
+ * @return void
+ */
+void task_sched_get_stats(Task_id_t id, Task_stats_t *stats);
+
+/**
+ * @brief Print scheduler statistics
+ *
+ * Wakeups per minute and, for each task, runs, coalesced runs, overruns and run time.
+ *
+ * no @param
+ *
+ * @return void
+ */
+void task_sched_report(void);
+
+#endif
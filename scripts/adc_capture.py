@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+# Copyright (c) 2025 Marconatale Parise.
+# SPDX-License-Identifier: Apache-2.0
+"""
+Convert a console capture of ADC samples into the replay table used by the
+ADC emulator backend (src/peripheral/adc_replay.c).
+
+The firmware prints one line per conversion when ADC_CAPTURE is enabled:
+    ADC_CAP,<timestamp ms>,<channel>,<raw>,<millivolts>
+Any other console line is ignored, so a full log can be used as input.
+"""
+
+import argparse
+import re
+import sys
+
+CAPTURE_RE = re.compile(r'ADC_CAP,(\d+),(\d+),(-?\d+),(-?\d+)')
+
+
+def parse(path):
+    samples = []
+    if not path:
+        return samples
+    with open(path, encoding='utf-8', errors='replace') as f:
+        for line in f:
+            m = CAPTURE_RE.search(line)
+            if m:
+                ts, ch, _raw, mv = (int(v) for v in m.groups())
+                samples.append((ts, ch, max(0, mv)))
+    if samples:
+        # Timestamps are relative to the first sample of the capture
+        t0 = samples[0][0]
+        samples = [(ts - t0, ch, mv) for ts, ch, mv in samples]
+    return samples
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--log', default='', help='console capture, empty for no samples')
+    parser.add_argument('--output', required=True, help='generated C header')
+    args = parser.parse_args()
+
+    samples = parse(args.log)
+    lines = [
+        '/* Generated by scripts/adc_capture.py, do not edit. */',
+        f'/* Source: {args.log or "none"} */',
+        '#define ADC_REPLAY_NUM_SAMPLES %d' % len(samples),
+        '#define ADC_REPLAY_SPAN_MS %d' % (samples[-1][0] if samples else 0),
+        '',
+        'static const Adc_replay_sample_t adc_replay_samples[] = {',
+    ]
+    lines += ['  {%d, %d, %d},' % s for s in samples]
+    if not samples:
+        lines.append('  {0, 0, 0},')
+    lines.append('};')
+
+    with open(args.output, 'w', encoding='utf-8') as f:
+        f.write('\n'.join(lines) + '\n')
+    print(f'adc_capture: {len(samples)} samples written to {args.output}')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
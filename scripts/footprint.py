@@ -0,0 +1,241 @@
+#!/usr/bin/env python3
+# Copyright (c) 2025 Marconatale Parise.
+# SPDX-License-Identifier: Apache-2.0
+"""
+Footprint budget tool for the NORAB106 heart rate application.
+
+Sub-commands:
+  report  parse the linker map file and print RAM/ROM usage per module
+          (application objects are reported one by one, libraries per archive)
+  check   compare a report against the committed budget and fail on regression
+          or on an application module without a budget entry
+  budget  derive the budget from a report of a real build: every application
+          module and every module already budgeted, plus a margin
+  stacks  parse a thread analyzer log and emit a Kconfig fragment with
+          right-sized thread stacks and bluetooth buffer counts
+"""
+
+import argparse
+import json
+import re
+import sys
+
+RAM_BASE = 0x20000000
+RAM_END = 0x40000000
+
+# Input section line: " .text.foo  0x00008000  0x20 app/libapp.a(main.c.obj)"
+# Long section names are printed alone and the address follows on the next line.
+SECTION_RE = re.compile(r'^ (\.\S+|COMMON)\s*$')
+ENTRY_RE = re.compile(r'^ (?:(\.\S+|COMMON))?\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$')
+ARCHIVE_RE = re.compile(r'(?:^|/)lib([^/]+)\.a\(([^)]+)\)$')
+
+# Thread analyzer line: "BT RX   : STACK: unused 576 usage 448 / 1024 (43 %); CPU: 0 %"
+ANALYZER_RE = re.compile(r'^\s*(.+?)\s*:\s*STACK:\s*unused\s+(\d+)\s+usage\s+(\d+)\s*/\s*(\d+)')
+
+# Thread name (CONFIG_THREAD_NAME) -> Kconfig symbol of its stack
+STACK_SYMBOLS = {
+    'BT RX': 'CONFIG_BT_RX_STACK_SIZE',
+    'BT RX pri': 'CONFIG_BT_CTLR_RX_PRIO_STACK_SIZE',
+    'BT TX': 'CONFIG_BT_HCI_TX_STACK_SIZE',
+    'BT ECC': 'CONFIG_BT_HCI_ECC_STACK_SIZE',
+    'sysworkq': 'CONFIG_SYSTEM_WORKQUEUE_STACK_SIZE',
+    'logging': 'CONFIG_LOG_PROCESS_THREAD_STACK_SIZE',
+    'idle 00': 'CONFIG_IDLE_STACK_SIZE',
+    'idle': 'CONFIG_IDLE_STACK_SIZE',
+    'main': 'CONFIG_MAIN_STACK_SIZE',
+    'thread_analyzer': 'CONFIG_THREAD_ANALYZER_AUTO_STACK_SIZE',
+    'proc_wq': 'CONFIG_APP_PROC_WQ_STACK_SIZE',
+}
+
+# Symbols that need a companion option to be overridden
+STACK_PROMPTS = {
+    'CONFIG_BT_HCI_TX_STACK_SIZE': 'CONFIG_BT_HCI_TX_STACK_SIZE_WITH_PROMPT',
+}
+
+
+def module_name(owner):
+    m = ARCHIVE_RE.search(owner)
+    if not m:
+        return None
+    lib, obj = m.groups()
+    if lib == 'app':
+        return 'app/' + obj.replace('.c.obj', '')
+    return lib
+
+
+def parse_map(path):
+    usage = {}
+    pending = None
+    in_map = False
+    with open(path, encoding='utf-8', errors='replace') as f:
+        for line in f:
+            if line.startswith('Linker script and memory map'):
+                in_map = True
+                continue
+            if not in_map:
+                continue
+            m = SECTION_RE.match(line)
+            if m:
+                pending = m.group(1)
+                continue
+            m = ENTRY_RE.match(line)
+            if not m:
+                pending = None
+                continue
+            name = m.group(1) or pending
+            pending = None
+            if name is None:
+                continue
+            addr = int(m.group(2), 16)
+            size = int(m.group(3), 16)
+            module = module_name(m.group(4).strip())
+            if module is None or size == 0 or name.startswith('.debug') or addr == 0:
+                continue
+            entry = usage.setdefault(module, {'ram': 0, 'rom': 0})
+            if RAM_BASE <= addr < RAM_END:
+                entry['ram'] += size
+            else:
+                entry['rom'] += size
+    return usage
+
+
+def cmd_report(args):
+    usage = parse_map(args.map)
+    total = {'ram': sum(u['ram'] for u in usage.values()),
+             'rom': sum(u['rom'] for u in usage.values())}
+    print(f"{'module':<44}{'RAM':>10}{'ROM':>10}")
+    for name, u in sorted(usage.items(), key=lambda kv: -(kv[1]['ram'] + kv[1]['rom'])):
+        print(f"{name:<44}{u['ram']:>10}{u['rom']:>10}")
+    print(f"{'total':<44}{total['ram']:>10}{total['rom']:>10}")
+    if args.json:
+        with open(args.json, 'w', encoding='utf-8') as f:
+            json.dump({'total': total, 'modules': usage}, f, indent=2, sort_keys=True)
+    return 0
+
+
+def cmd_check(args):
+    with open(args.report, encoding='utf-8') as f:
+        report = json.load(f)
+    with open(args.budget, encoding='utf-8') as f:
+        budget = json.load(f)
+    failures = []
+    for kind in ('ram', 'rom'):
+        used = report['total'][kind]
+        limit = budget['total'][kind]
+        if used > limit:
+            failures.append(f"total {kind.upper()} {used} > budget {limit}")
+    # A new application object must come with its budget, or it would grow unchecked
+    for name in sorted(report['modules']):
+        if name.startswith('app/') and name not in budget.get('modules', {}):
+            failures.append(f"{name} has no budget entry")
+    for name, limits in budget.get('modules', {}).items():
+        used = report['modules'].get(name, {'ram': 0, 'rom': 0})
+        for kind in ('ram', 'rom'):
+            if kind in limits and used[kind] > limits[kind]:
+                failures.append(f"{name} {kind.upper()} {used[kind]} > budget {limits[kind]}")
+    for msg in failures:
+        print('footprint: ' + msg, file=sys.stderr)
+    if not failures:
+        print(f"footprint: within budget (RAM {report['total']['ram']}/{budget['total']['ram']}, "
+              f"ROM {report['total']['rom']}/{budget['total']['rom']})")
+    return 1 if failures else 0
+
+
+def round_up(value, step):
+    return (value + step - 1) // step * step
+
+
+def cmd_budget(args):
+    with open(args.report, encoding='utf-8') as f:
+        report = json.load(f)
+    kept = set()
+    if args.budget:
+        with open(args.budget, encoding='utf-8') as f:
+            kept = set(json.load(f).get('modules', {}))
+    modules = {}
+    for name, used in sorted(report['modules'].items()):
+        if name.startswith('app/') or name in kept:
+            modules[name] = {kind: round_up(used[kind] * (100 + args.margin) // 100, 64)
+                             for kind in ('ram', 'rom')}
+    total = {kind: round_up(report['total'][kind] * (100 + args.margin) // 100, 1024)
+             for kind in ('ram', 'rom')}
+    with open(args.output, 'w', encoding='utf-8') as f:
+        json.dump({'total': total, 'modules': modules}, f, indent=2)
+        f.write('\n')
+    print(f"footprint: {args.output} written (RAM {total['ram']}, ROM {total['rom']}, "
+          f"{len(modules)} modules, margin {args.margin} %)")
+    return 0
+
+
+def cmd_stacks(args):
+    high_water = {}
+    with open(args.log, encoding='utf-8', errors='replace') as f:
+        for line in f:
+            m = ANALYZER_RE.match(line)
+            if m:
+                name = m.group(1).strip()
+                # Keep the worst case seen across all analyzer passes
+                high_water[name] = max(high_water.get(name, 0), int(m.group(3)))
+
+    lines = ['# Generated by scripts/footprint.py stacks, do not edit.',
+             f'# Source log: {args.log}, margin {args.margin} %']
+    for name, used in sorted(high_water.items()):
+        symbol = STACK_SYMBOLS.get(name)
+        if symbol is None:
+            lines.append(f'# {name}: usage {used}, no Kconfig symbol known')
+            continue
+        size = used * (100 + args.margin) // 100
+        size = max(args.min_stack, (size + 7) // 8 * 8)
+        lines.append(f'# {name}: usage {used}')
+        if symbol in STACK_PROMPTS:
+            lines.append(f'{STACK_PROMPTS[symbol]}=y')
+        lines.append(f'{symbol}={size}')
+
+    # One ACL buffer per notification queued in an update cycle plus one for ATT responses
+    acl_tx = max(2, args.notify_per_cycle + 1)
+    lines.append('CONFIG_BT_CONN_TX_MAX=%d' % acl_tx)
+    lines.append('CONFIG_BT_BUF_ACL_TX_COUNT=%d' % (acl_tx + 1))
+
+    with open(args.output, 'w', encoding='utf-8') as f:
+        f.write('\n'.join(lines) + '\n')
+    print(f"footprint: {args.output} written ({len(high_water)} threads)")
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest='cmd', required=True)
+
+    p = sub.add_parser('report', help='per-module RAM/ROM report from the linker map')
+    p.add_argument('--map', required=True, help='zephyr_final.map or zephyr.map')
+    p.add_argument('--json', help='store the report in a JSON file')
+    p.set_defaults(func=cmd_report)
+
+    p = sub.add_parser('check', help='compare a JSON report against the budget')
+    p.add_argument('--report', required=True)
+    p.add_argument('--budget', required=True)
+    p.set_defaults(func=cmd_check)
+
+    p = sub.add_parser('budget', help='derive the budget from a JSON report')
+    p.add_argument('--report', required=True)
+    p.add_argument('--budget', help='current budget: its modules are kept')
+    p.add_argument('--output', required=True)
+    p.add_argument('--margin', type=int, default=10, help='headroom in percent')
+    p.set_defaults(func=cmd_budget)
+
+    p = sub.add_parser('stacks', help='Kconfig fragment from a thread analyzer log')
+    p.add_argument('--log', required=True, help='console capture with thread analyzer output')
+    p.add_argument('--output', required=True, help='generated Kconfig fragment')
+    p.add_argument('--margin', type=int, default=25, help='safety margin in percent')
+    p.add_argument('--min-stack', type=int, default=128)
+    p.add_argument('--notify-per-cycle', type=int, default=2,
+                   help='notifications queued in one update cycle (HRS + BAS)')
+    p.set_defaults(func=cmd_stacks)
+
+    args = parser.parse_args()
+    return args.func(args)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -9,12 +9,12 @@
  *****************************************************************************/
 /**
  * @file main.c
- * @brief main function to initialize peripherals and provide threads for bluetooth 
- * and peripheral handling
+ * @brief main function to initialize peripherals and register the bluetooth tasks
  *
  * This file contains the main function that initializes the peripherals and
- * provides heartbeat and battery service over Bluetooth each 5 seconds or using dedicated 
- * buttons.
+ * provides heartbeat and battery service over Bluetooth periodically or using dedicated 
+ * buttons. The tasks run on the processing workqueue (task_sched.h), no application thread 
+ * is left.
  * 
  * @author Marconatale Parise
  * @date 09 June 2025
@@ -25,47 +25,97 @@
 #include "common.h"
 
 
-/* size of stack area used by each thread */
-#define STACKSIZE 1024
-/* scheduling priority used by each thread */
-#define PRIORITY 7
-#define HIGH_PRIORITY 5
+#define BT_BATTERY_PERIOD_MS  CONFIG_APP_BT_BATTERY_PERIOD_MS
 
-void main(void){
-	peripheral_init();
+/* Tasks of the scheduler, run on the processing workqueue: values are staged and sent 
+ * in one flush at the end of the wakeup */
+static void notify_task(void){
+#if defined(CONFIG_APP_BT_SYNC)
+	uint32_t delay_ms;
+
+	// Sample and stage just before the next connection event, free running without estimate
+	if (bt_sync_next_ms(CONFIG_APP_BT_SYNC_LEAD_US, &delay_ms)) {
+		task_sched_run_in(TASK_SYNC, delay_ms);
+		return;
+	}
+#endif
+	(void)bt_hrs_stage();
+}
+
+#if defined(CONFIG_APP_BT_SYNC)
+static void sync_task(void){
+	proc_wq_sample_now(BIT(HR_CH));
+	(void)bt_hrs_stage();
+}
+#endif
+
+static void battery_task(void){
+	(void)bt_bas_stage();
 }
 
-void bt_thread(void){
-	while(1){
-		bt_hrs_set();
-		bt_bas_set();
-		k_sleep(K_MSEC(5000));
-  }
+static void summary_task(void){
+	(void)bt_summary_stage();
 }
 
-void bt_event_thread(void){
-	while(1){
-		 // Check if Button 1 is pressed
-		if(is_button1_pressed()){
-			bt_hrs_set();
-		}
-		// Check if Button 2 is pressed
-		if(is_button2_pressed()){
-			bt_bas_set();
-		}
-		k_sleep(K_MSEC(50));
-		
-  }
+static void buttons_task(void){
+	// Check if Button 1 is pressed
+	if(is_button1_pressed()){
+		(void)bt_hrs_stage();
+	}
+	// Check if Button 2 is pressed
+	if(is_button2_pressed()){
+		(void)bt_bas_stage();
+	}
 }
 
-void perip_thread(void){
-	while(1){
-		set_heart_rate_value();
-		set_battery_perc();
-		k_sleep(K_MSEC(100));
-  }
+/* Each module prints its own statistics */
+static void report_task(void){
+	adc_report();
+	perip_report();
+	accel_fifo_report();
+	motion_lms_report();
+	meas_rec_report();
+	hr_agg_report();
+#if defined(CONFIG_APP_HRV)
+	hrv_report();
+#endif
+	latency_hist_report();
+	bt_notify_report();
+	bt_sync_report();
+	bt_adv_report();
+	proc_wq_report();
+	energy_report();
 }
 
-K_THREAD_DEFINE(bt_thread_id, STACKSIZE, bt_thread, NULL, NULL, NULL, PRIORITY, 0, 0);
-K_THREAD_DEFINE(bt_event_thread_id, STACKSIZE, bt_event_thread, NULL, NULL, NULL, HIGH_PRIORITY, 0, 0);
-K_THREAD_DEFINE(perip_thread_id, STACKSIZE, perip_thread, NULL, NULL, NULL,	PRIORITY, 0, 0);
\ No newline at end of file
+/* gpio ISR: wake up the buttons task */
+static void buttons_event(void){
+	task_sched_post(TASK_BUTTONS);
+}
+
+void main(void){
+	App_cfg_t cfg;
+
+	peripheral_init();
+	// Before settings are restored by bt_ready()
+	app_cfg_init();
+
+	// Sampling only depends on gpio and adc, start it while the network core is still booting
+	proc_wq_start();
+	task_sched_add(TASK_REPORT, "report", report_task, REPORT_PERIOD_MS, 0, TASK_SLACK_MS);
+
+	if (!bt_wait_ready(K_MSEC(BT_READY_TIMEOUT_MS))) {
+		LOG("Bluetooth not ready after %d ms\n", BT_READY_TIMEOUT_MS);
+		return;
+	}
+	// Period restored from settings by bt_ready(), before the task exists
+	app_cfg_get(&cfg);
+	// Same phase: battery level goes with every n-th heart rate notification
+	task_sched_add(TASK_NOTIFY, "notify", notify_task, cfg.notify_period_ms, 0, TASK_SLACK_MS);
+	task_sched_add(TASK_BATTERY, "battery", battery_task, BT_BATTERY_PERIOD_MS, 0, TASK_SLACK_MS);
+	task_sched_add(TASK_SUMMARY, "summary", summary_task, hr_agg_window_get(), 0, TASK_SLACK_MS);
+	task_sched_add(TASK_BUTTONS, "buttons", buttons_task, 0, 0, 0);
+#if defined(CONFIG_APP_BT_SYNC)
+	task_sched_add(TASK_SYNC, "sync", sync_task, 0, 0, 0);
+#endif
+	gpio_set_event_handler(buttons_event);
+}
@@ -0,0 +1,221 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file accel_fifo.c
+ * @brief accelerometer FIFO function definitions
+ *
+ * A drain costs two bus transactions (FIFO status, burst read of the samples) for up to 
+ * ACCEL_FIFO_DEPTH samples, instead of one or more transactions for every sample.
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "accel_fifo.h"
+
+#if ACCEL_ENABLED
+#include <stdlib.h>
+#include <zephyr/drivers/i2c.h>
+#include <zephyr/drivers/gpio.h>
+
+#define ACCEL_SAMPLE_BYTES  6
+#define ACCEL_HIST_MASK     (ACCEL_HIST_LEN - 1U)
+
+typedef struct
+{
+  uint32_t ts_cyc;
+  int16_t  ref;     // magnitude minus mean, mg
+}Accel_hist_t;
+
+static const struct i2c_dt_spec accel = I2C_DT_SPEC_GET(DT_ALIAS(accel0));
+static const struct gpio_dt_spec accel_int = GPIO_DT_SPEC_GET_BY_IDX(DT_ALIAS(accel0), irq_gpios, 0);
+static struct gpio_callback accel_int_cb;
+
+static void accel_drain(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(drain_work, accel_drain);
+static struct k_work_q *drain_queue;
+
+static uint8_t fifo_raw[ACCEL_FIFO_DEPTH * ACCEL_SAMPLE_BYTES];
+static Accel_hist_t hist[ACCEL_HIST_LEN];
+static uint32_t hist_head;    // samples written since start, free running
+static int32_t mag_mean_q4;   // running mean of the magnitude, mg in Q4
+static bool accel_ok;
+static Accel_stats_t accel_stats;
+
+
+/***********************************************************
+ Static Function Definitions
+***********************************************************/
+static void accel_int_handler(const struct device *dev, struct gpio_callback *cb, uint32_t pins){
+  if (drain_queue != NULL){
+    (void)k_work_reschedule_for_queue(drain_queue, &drain_work, K_NO_WAIT);
+  }
+}
+
+static int accel_write(uint8_t reg, uint8_t val){
+  accel_stats.bus_xfers++;
+  return i2c_reg_write_byte_dt(&accel, reg, val);
+}
+
+static void accel_hist_add(uint32_t ts_cyc, const uint8_t *raw){
+  // 12-bit left aligned samples, 1 mg/digit at +-2 g
+  int32_t x = (int16_t)(raw[0] | (raw[1] << 8)) >> 4;
+  int32_t y = (int16_t)(raw[2] | (raw[3] << 8)) >> 4;
+  int32_t z = (int16_t)(raw[4] | (raw[5] << 8)) >> 4;
+  // L1 norm: no square root, good enough as a motion reference
+  int32_t mag = abs(x) + abs(y) + abs(z);
+
+  if (hist_head == 0){
+    mag_mean_q4 = mag << 4;
+  }
+  // Exponential average with weight 1/16 removes gravity and slow posture changes
+  mag_mean_q4 = ema_step(mag_mean_q4, mag << 4, 4);
+  hist[hist_head & ACCEL_HIST_MASK].ts_cyc = ts_cyc;
+  hist[hist_head & ACCEL_HIST_MASK].ref = (int16_t)CLAMP(mag - (mag_mean_q4 >> 4), INT16_MIN, INT16_MAX);
+  hist_head++;
+}
+
+static void accel_drain(struct k_work *work){
+  uint32_t start = k_cycle_get_32();
+  uint32_t odr_cyc = sys_clock_hw_cycles_per_sec() / ACCEL_ODR_HZ;
+  uint8_t src;
+  uint8_t n;
+
+  accel_stats.bus_xfers++;
+  if (i2c_reg_read_byte_dt(&accel, ACCEL_REG_FIFO_SRC, &src) == 0){
+    n = src & ACCEL_FIFO_SRC_FSS;
+    if (src & ACCEL_FIFO_SRC_OVRN){
+      accel_stats.overruns++;
+      n = ACCEL_FIFO_DEPTH;
+    }
+    accel_stats.bus_xfers++;
+    if (n > 0 && i2c_burst_read_dt(&accel, ACCEL_REG_OUT_X_L | ACCEL_REG_AUTO_INC, fifo_raw, n * ACCEL_SAMPLE_BYTES) == 0){
+      // The newest sample is taken now, the older ones one output period apart
+      for (uint8_t i = 0; i < n; i++){
+        accel_hist_add(start - (uint32_t)(n - 1U - i) * odr_cyc, &fifo_raw[i * ACCEL_SAMPLE_BYTES]);
+      }
+      accel_stats.samples += n;
+    }
+    accel_stats.drains++;
+  }
+  accel_stats.cycles_total += k_cycle_get_32() - start;
+  (void)k_work_reschedule_for_queue(drain_queue, &drain_work, K_MSEC(ACCEL_DRAIN_TIMEOUT_MS));
+}
+
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+int accel_fifo_init(void){
+  uint8_t id = 0;
+
+  if (!device_is_ready(accel.bus) || !device_is_ready(accel_int.port)){
+    LOG("Accelerometer bus not ready");
+    return -ENODEV;
+  }
+  accel_stats.bus_xfers++;
+  if (i2c_reg_read_byte_dt(&accel, ACCEL_REG_WHO_AM_I, &id) < 0 || id != ACCEL_WHO_AM_I){
+    LOG("Accelerometer not found (id 0x%02x)", id);
+    return -ENODEV;
+  }
+  if (accel_write(ACCEL_REG_CTRL1, ACCEL_CTRL1_50HZ_XYZ) < 0 ||
+      accel_write(ACCEL_REG_CTRL4, ACCEL_CTRL4_BDU_HR) < 0 ||
+      accel_write(ACCEL_REG_CTRL5, ACCEL_CTRL5_FIFO_EN) < 0 ||
+      accel_write(ACCEL_REG_FIFO_CTRL, ACCEL_FIFO_STREAM | ACCEL_FIFO_WATERMARK) < 0 ||
+      accel_write(ACCEL_REG_CTRL3, ACCEL_CTRL3_I1_WTM) < 0){
+    LOG("Accelerometer configuration failed");
+    return -EIO;
+  }
+
+  gpio_pin_configure_dt(&accel_int, GPIO_INPUT);
+  gpio_init_callback(&accel_int_cb, accel_int_handler, BIT(accel_int.pin));
+  gpio_add_callback(accel_int.port, &accel_int_cb);
+  gpio_pin_interrupt_configure_dt(&accel_int, GPIO_INT_EDGE_TO_ACTIVE);
+  accel_ok = true;
+  LOG("Accelerometer FIFO: %d Hz, watermark %d samples", ACCEL_ODR_HZ, ACCEL_FIFO_WATERMARK);
+  return 0;
+}
+
+void accel_fifo_start(struct k_work_q *queue){
+  if (accel_ok){
+    drain_queue = queue;
+    // First drain also empties what was stored while the workqueue was not running
+    (void)k_work_reschedule_for_queue(drain_queue, &drain_work, K_NO_WAIT);
+  }
+}
+
+bool accel_fifo_ready(void){
+  return accel_ok;
+}
+
+bool accel_fifo_ref_at(uint32_t ts_cyc, int16_t *ref, uint8_t n, uint32_t max_skew_cyc){
+  uint32_t avail = MIN(hist_head, ACCEL_HIST_LEN);
+  uint32_t j = hist_head;
+
+  // Newest history sample not after ts_cyc
+  while (avail > 0 && (int32_t)(hist[(j - 1U) & ACCEL_HIST_MASK].ts_cyc - ts_cyc) > 0){
+    j--;
+    avail--;
+  }
+  if (avail < n || (ts_cyc - hist[(j - 1U) & ACCEL_HIST_MASK].ts_cyc) > max_skew_cyc){
+    return false;
+  }
+  for (uint8_t i = 0; i < n; i++){
+    ref[i] = hist[(j - n + i) & ACCEL_HIST_MASK].ref;
+  }
+  return true;
+}
+
+void accel_fifo_get_stats(Accel_stats_t *stats){
+  *stats = accel_stats;
+}
+
+#else
+
+int accel_fifo_init(void){
+  return -ENODEV;
+}
+
+void accel_fifo_start(struct k_work_q *queue){
+}
+
+bool accel_fifo_ready(void){
+  return false;
+}
+
+bool accel_fifo_ref_at(uint32_t ts_cyc, int16_t *ref, uint8_t n, uint32_t max_skew_cyc){
+  return false;
+}
+
+void accel_fifo_get_stats(Accel_stats_t *stats){
+  *stats = (Accel_stats_t){0};
+}
+
+#endif
+
+void accel_fifo_report(void){
+  uint32_t now = k_uptime_get_32();
+  Accel_stats_t accel;
+
+  if (!accel_fifo_ready() || now == 0){
+    return;
+  }
+  accel_fifo_get_stats(&accel);
+  LOG("Accel: %u bus transfers/s, %u samples/s, %u cycles/sample, %u FIFO overruns",
+      (uint32_t)((uint64_t)accel.bus_xfers * 1000U / now), (uint32_t)((uint64_t)accel.samples * 1000U / now),
+      accel.samples ? accel.cycles_total / accel.samples : 0, accel.overruns);
+}
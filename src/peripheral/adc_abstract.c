@@ -26,41 +26,215 @@
  *
  */
 #include "adc_abstract.h"
+#include <string.h>
+#if defined(CONFIG_ADC_EMUL)
+#include "adc_replay.h"
+#define ADC_PERIOD_DIV  ADC_REPLAY_SPEED  // replay: the capture is sampled N times faster
+#else
+#define ADC_PERIOD_DIV  1
+#endif
+#if ADC_CALIB_USE_DIE_TEMP
+#include <stdlib.h>
+#include <zephyr/drivers/sensor.h>
+#endif
 
-int16_t buf;
+static int16_t buf; // conversion result, written by the adc driver only
+static Spsc_ring_t adc_ring;
+static uint32_t adc_ring_max_pending;
+static adc_filter_t adc_filter[ADC_NUM_CHANNELS];
 
-Adc_t adc_a[ADC_NUM_CHANNELS] = {
+static enum adc_action adc_sample_done(const struct device *dev, const struct adc_sequence *seq, uint16_t sampling_index);
+
+static Adc_rate_cfg_t adc_rate_cfg[ADC_NUM_CHANNELS] = {
+  [HR_CH]   = {.min_period_ms = HR_RATE_MIN_MS,   .max_period_ms = HR_RATE_MAX_MS,   .thr_mv = HR_RATE_THR_MV},
+  [BATT_CH] = {.min_period_ms = BATT_RATE_MIN_MS, .max_period_ms = BATT_RATE_MAX_MS, .thr_mv = BATT_RATE_THR_MV},
+};
+
+static Adc_glitch_cfg_t adc_glitch_cfg[ADC_NUM_CHANNELS] = {
+  [HR_CH]   = {.range_mv = RANGE_MV, .limit = LIMIT_ADC_SPIKE},
+  [BATT_CH] = {.range_mv = RANGE_MV, .limit = LIMIT_ADC_SPIKE},
+};
+
+BUILD_ASSERT((uint64_t)BUFFER_SIZE * ADC_SAMPLE_MAX <= UINT32_MAX, "adc_get_media() accumulator overflow");
+
+static Adc_t adc_a[ADC_NUM_CHANNELS] = {
   {
-    .pin = DT_IO_CHANNELS_INPUT_BY_IDX(DT_PATH(zephyr_user), 0),
-    .status = true,
+    .counter_spike = 0,
     .fbuf = {
-      .length = BUFFER_SIZE, // Set the length of the buffer
-      .data_set = {0x00, 0x00, 0x00, 0x00, 0x00}, // Initialize data_set with zeros
-      .data_media = 0, // Initialize data_media to zero
-      .count = 0 // Initialize count to zero
+      .length = ADC_FILTER_LEN, // Set the length of the buffer
+      .count = 0, // Initialize count to zero
+      .data_set = {0}, // Initialize data_set with zeros
+      .data_media = 0 // Initialize data_media to zero
     },
-    .counter_spike = 0
+    .rate = {.period_ms = HR_RATE_MIN_MS, .next_ms = 0, .conversions = 0, .last = 0},
+    .quality = {.sqi = SQI_MAX}
   }, //HR_CH
   {
-    .pin = DT_IO_CHANNELS_INPUT_BY_IDX(DT_PATH(zephyr_user), 1),
-    .status = true,
+    .counter_spike = 0,
     .fbuf = {
-      .length = BUFFER_SIZE, // Set the length of the buffer
-      .data_set = {0x00, 0x00, 0x00, 0x00, 0x00}, // Initialize data_set with zeros
-      .data_media = 0, // Initialize data_media to zero
-      .count = 0 // Initialize count to zero
+      .length = ADC_FILTER_LEN, // Set the length of the buffer
+      .count = 0, // Initialize count to zero
+      .data_set = {0}, // Initialize data_set with zeros
+      .data_media = 0 // Initialize data_media to zero
     },
-    .counter_spike = 0
+    .rate = {.period_ms = BATT_RATE_MIN_MS, .next_ms = 0, .conversions = 0, .last = 0},
+    .quality = {.sqi = SQI_MAX}
   } //BATT_CH
 };
  
-struct adc_sequence sequence = {
+/* Each channel passes its index to the completion callback */
+static const struct adc_sequence_options adc_seq_opts[ADC_NUM_CHANNELS] = {
+  [HR_CH]   = {.callback = adc_sample_done, .user_data = (void *)HR_CH},
+  [BATT_CH] = {.callback = adc_sample_done, .user_data = (void *)BATT_CH},
+};
+
+static struct adc_sequence sequence = {
   .buffer = &buf,
   /* buffer size in bytes, not number of samples */
   .buffer_size = sizeof(buf),
   .resolution  = 12,
 };
 
+static atomic_t calib_pending = ATOMIC_INIT(1); // first conversion calibrates
+static uint32_t calib_last_ms;
+
+#if ADC_CALIB_USE_DIE_TEMP
+static const struct device *const die_temp = DEVICE_DT_GET(DT_ALIAS(die_temp0));
+static uint32_t temp_check_ms;
+static int32_t calib_temp_c;
+static int32_t last_temp_c;
+#endif
+
+
+/***********************************************************
+ Static Function Definitions
+***********************************************************/
+/* Time to the next conversion: the period in capture time, divided when replaying */
+static uint32_t rate_delay_ms(uint32_t period_ms){
+  return MAX(period_ms / ADC_PERIOD_DIV, 1U);
+}
+
+#if ADC_CALIB_USE_DIE_TEMP
+static bool die_temp_read(int32_t *temp_c){
+  struct sensor_value val;
+  if (!device_is_ready(die_temp) || sensor_sample_fetch(die_temp) < 0 ||
+      sensor_channel_get(die_temp, SENSOR_CHAN_DIE_TEMP, &val) < 0){
+    return false;
+  }
+  *temp_c = val.val1;
+  return true;
+}
+#endif
+
+static bool adc_calib_due(uint32_t now){
+  if ((now - calib_last_ms) >= ADC_CALIB_INTERVAL_MS){
+    atomic_set(&calib_pending, 1);
+  }
+#if ADC_CALIB_USE_DIE_TEMP
+  // Temperature is checked at a low rate, the sensor read is more expensive than a conversion
+  if ((now - temp_check_ms) >= ADC_CALIB_TEMP_CHECK_MS){
+    temp_check_ms = now;
+    if (die_temp_read(&last_temp_c) && abs(last_temp_c - calib_temp_c) >= ADC_CALIB_TEMP_DELTA_C){
+      atomic_set(&calib_pending, 1);
+    }
+  }
+#endif
+  return atomic_get(&calib_pending) != 0;
+}
+
+static void adc_calib_done(uint8_t channel, uint32_t now){
+  atomic_clear(&calib_pending);
+  calib_last_ms = now;
+  adc_a[channel].perf.calibrations++;
+#if ADC_CALIB_USE_DIE_TEMP
+  calib_temp_c = last_temp_c;
+#endif
+  LOG_ADC("Offset calibration done with channel %d\n", channel);
+}
+
+static void adc_quality_update(uint8_t channel, bool rejected){
+  Adc_quality_t *q = &adc_a[channel].quality;
+  uint8_t consec = rejected ? adc_a[channel].counter_spike : 0;
+  int32_t reject_pct;
+  int32_t noise_pen;
+  int32_t sqi;
+
+  q->samples++;
+  if (rejected){
+    q->rejects++;
+  }
+  q->max_consec = MAX(q->max_consec, consec);
+  // Exponential average with weight 1/16 of the reject indicator (1.0 = 4096)
+  q->reject_rate_q12 = (uint16_t)ema_step(q->reject_rate_q12, rejected ? 4096 : 0, 4);
+
+  reject_pct = ((int32_t)q->reject_rate_q12 * 100) >> 12;
+  noise_pen = (int32_t)MIN((adc_a[channel].perf.noise_q8 * SQI_MAX) / (SQI_NOISE_FULL_MV << 8), SQI_MAX);
+  sqi = SQI_MAX - reject_pct * SQI_REJECT_WEIGHT - consec * SQI_CONSEC_WEIGHT - noise_pen;
+  q->sqi = (uint8_t)CLAMP(sqi, 0, SQI_MAX);
+}
+
+static void adc_perf_cycles(uint8_t channel, uint32_t cycles){
+  Adc_perf_t *perf = &adc_a[channel].perf;
+  perf->cycles_total += cycles;
+  perf->cycles_max = MAX(perf->cycles_max, cycles);
+}
+
+static void adc_perf_noise(uint8_t channel, adc_sample_t sample){
+  Adc_perf_t *perf = &adc_a[channel].perf;
+  uint16_t media = adc_a[channel].fbuf.data_media;
+  uint16_t dev = (sample > media) ? sample - media : media - sample;
+  // Exponential average with weight 1/8, Q8 keeps the fractional mV
+  perf->noise_q8 = (uint32_t)ema_step((int32_t)perf->noise_q8, (int32_t)MIN(dev, 4095) << 8, 3);
+}
+
+/* Conversion complete, called by the adc driver in interrupt context: producer side of the ring */
+static enum adc_action adc_sample_done(const struct device *dev, const struct adc_sequence *seq, uint16_t sampling_index){
+  Adc_raw_sample_t s = {
+    .ts_cyc = k_cycle_get_32(),
+    .raw = *(const int16_t *)seq->buffer,
+    .channel = (uint8_t)(uintptr_t)seq->options->user_data,
+  };
+  (void)spsc_ring_push(&adc_ring, &s);
+  return ADC_ACTION_FINISH;
+}
+
+/* Processing stage, consumer side of the ring: raw to mV, glitch check, quality and FIFO media */
+static void adc_process_sample(const Adc_raw_sample_t *raw){
+  uint8_t channel = raw->channel;
+  int32_t val_mv = raw->raw;
+  adc_sample_t sample;
+  uint32_t start = k_cycle_get_32();
+  int err;
+
+  __ASSERT_NO_MSG(channel < ADC_NUM_CHANNELS);
+  err = adc_raw_to_millivolts_dt(&adc_channels[channel], &val_mv);
+  if (err < 0) {
+    LOG_ADC(" (value in mV not available)\n");
+  } else {
+    LOG_ADC("Channel %"PRId32" = %"PRId32" mV\n", channel, val_mv);
+    if (ADC_CAPTURE) {
+      printf("ADC_CAP,%u,%u,%d,%"PRId32"\n", k_uptime_get_32(), channel, raw->raw, val_mv);
+    }
+  }
+  sample = adc_sample_sat(val_mv);
+  if (adc_filter[channel] != NULL){
+    sample = adc_filter[channel](sample, raw->ts_cyc);
+  }
+  adc_rate_update(channel, sample);
+  // Single evaluation per sample: the spike counter must not be advanced twice
+  uint8_t spikes = spike_counter(channel, sample);
+  bool rejected = (spikes != NO_ADC_SPIKE) && (spikes < adc_glitch_cfg[channel].limit);
+  adc_quality_update(channel, rejected);
+  if (!rejected){
+    Ff_buffer_add(channel, sample); // Add new data to the FIFO buffer
+    adc_a[channel].counter_spike = NO_ADC_SPIKE; // Reset spike counter if data is valid
+    adc_a[channel].fbuf.data_media = adc_get_media(channel); // Calculate media from the buffer
+    adc_a[channel].sample_cyc = raw->ts_cyc;
+  }
+  adc_perf_noise(channel, sample);
+  adc_perf_cycles(channel, k_cycle_get_32() - start);
+}
+
 
 /***********************************************************
  Function Definitions
@@ -79,117 +253,249 @@ void adc_init(){
 			LOG_ADC("Could not setup channel #%d (%d)\n", i, err);
 			return;
 		}
+
+		// Hardware oversampling already averages, keep only a short software window
+		if (adc_channels[i].oversampling > 0) {
+			adc_a[i].fbuf.length = MIN(ADC_SW_AVG_OVERSAMPLED, adc_a[i].fbuf.length);
+		}
 	}
 }
 
 
-void Ff_buffer_add(uint8_t channel, int32_t data_read, uint8_t size){
-  if(channel < size){
-    if(adc_a[channel].status){
-      if(adc_a[channel].fbuf.count < adc_a[channel].fbuf.length){
-        adc_a[channel].fbuf.data_set[adc_a[channel].fbuf.count] = data_read; // Fill the buffer with the new data
-        adc_a[channel].fbuf.count++;
-      }else{
-        // Shift the buffer to make space for the new data
-        for(uint8_t i = 0; i < adc_a[channel].fbuf.length - 1; i++){
-          adc_a[channel].fbuf.data_set[i] = adc_a[channel].fbuf.data_set[i + 1];
-        }
-        adc_a[channel].fbuf.data_set[adc_a[channel].fbuf.length - 1] = data_read; // Add the new data at the end
-      }
+void Ff_buffer_add(uint8_t channel, int32_t data_read){
+  Fifo_buf_t *fbuf = &adc_a[channel].fbuf;
+  adc_sample_t sample = adc_sample_sat(data_read);
+
+  if(fbuf->count < fbuf->length){
+    fbuf->data_set[fbuf->count] = sample; // Fill the buffer with the new data
+    fbuf->count++;
+  }else{
+    // Shift the buffer to make space for the new data
+    for(uint8_t i = 0; i < fbuf->length - 1; i++){
+      fbuf->data_set[i] = fbuf->data_set[i + 1];
     }
+    fbuf->data_set[fbuf->length - 1] = sample; // Add the new data at the end
   }
 }
 
 
-bool data_is_valid(uint8_t channel, uint16_t data_read, uint8_t size){
-   if(channel < size){
-    if(adc_a[channel].status){
-      if(adc_a[channel].fbuf.count == adc_a[channel].fbuf.length){
-        uint16_t last_value = adc_a[channel].fbuf.data_set[adc_a[channel].fbuf.count - 1]; // Get the last value in the buffer
-        return ((data_read <= (last_value + RANGE)) & (data_read >= (last_value - RANGE)));
-      }else{
-        // If the buffer is not full, consider the data valid
-        return true;
-      }
-    }else{
-      return false; // If the channel is not valid, return false
-    }
-    
-  }else{
-    return false; // If the channel is out of bounds, return false
+bool data_is_valid(uint8_t channel, uint16_t data_read){
+  const Fifo_buf_t *fbuf = &adc_a[channel].fbuf;
+
+  if(fbuf->count == fbuf->length){
+    adc_sample_t last_value = fbuf->data_set[fbuf->count - 1]; // Get the last value in the buffer
+    int32_t range = adc_glitch_cfg[channel].range_mv;
+    return ((data_read <= (last_value + range)) & (data_read >= (last_value - range)));
   }
+  // If the buffer is not full, consider the data valid
+  return true;
 }
 
 
-uint8_t spike_counter( uint8_t channel,  uint16_t data_read, uint8_t size){
-  if(channel < size){
-    if(adc_a[channel].status){
-      if(!data_is_valid(channel, data_read, size)){
-          adc_a[channel].counter_spike ++; // First spike detected
-      }else{
-          adc_a[channel].counter_spike = NO_ADC_SPIKE; // Reset counter if data is valid
-      }
-    }
+uint8_t spike_counter( uint8_t channel,  uint16_t data_read){
+  if(!data_is_valid(channel, data_read)){
+    adc_a[channel].counter_spike ++; // First spike detected
+  }else{
+    adc_a[channel].counter_spike = NO_ADC_SPIKE; // Reset counter if data is valid
   }
   return adc_a[channel].counter_spike;
 }
 
 
 
-uint16_t adc_read_ch_data (uint8_t channel, uint8_t size){
-    int err;
-    int32_t val_mv;
-    if (channel >= ARRAY_SIZE(adc_channels)) {
-        LOG_ADC("Channel %d is out of bounds for size %d\n", channel, ARRAY_SIZE(adc_channels));
-        return 0; // Return 0 or handle error as needed
-    }else{
-
-      (void)adc_sequence_init_dt(&adc_channels[channel], &sequence);
-      // Read the ADC value for the specified channel and store it in the buffer "buf"
-      err = adc_read(adc_channels[channel].dev, &sequence);
-
-      if (adc_a[channel].status){
-        if (err >= 0) {
-          val_mv = buf;
-			    err = adc_raw_to_millivolts_dt(&adc_channels[channel],&val_mv);
-          if (err < 0) {
-            LOG_ADC(" (value in mV not available)\n");
-          } else {
-            LOG_ADC("Channel %"PRId32" = %"PRId32" mV\n", channel, val_mv);
-          }
-          if (spike_counter(channel, val_mv, size) == NO_ADC_SPIKE || spike_counter(channel, val_mv, size) >= LIMIT_ADC_SPIKE){
-            Ff_buffer_add(channel, val_mv, size); // Add new data to the FIFO buffer
-            adc_a[channel].counter_spike = NO_ADC_SPIKE; // Reset spike counter if data is valid
-            adc_a[channel].fbuf.data_media = adc_get_media(channel, size); // Calculate media from the buffer
-          }
-        }else {
-          LOG_ADC("ADC reading failed.\n");
-          return -1;
-        }
-      }
+int adc_sample_ch(uint8_t channel){
+  int err;
+  uint32_t start = k_cycle_get_32();
+  uint32_t now = k_uptime_get_32();
+  // Oversampling (and SAADC burst mode) comes from the channel devicetree node
+  (void)adc_sequence_init_dt(&adc_channels[channel], &sequence);
+  sequence.options = &adc_seq_opts[channel];
+  sequence.calibrate = adc_calib_due(now);
+  // The result is pushed in the sample ring by adc_sample_done() when the conversion completes
+  err = adc_read(adc_channels[channel].dev, &sequence);
+  if (err >= 0 && sequence.calibrate) {
+    adc_calib_done(channel, now);
+  }
+  adc_perf_cycles(channel, k_cycle_get_32() - start);
+  if (err < 0) {
+    LOG_ADC("ADC reading failed.\n");
+    // Retry after one period instead of spinning on a failing channel
+    adc_a[channel].rate.next_ms = k_uptime_get_32() + rate_delay_ms(adc_a[channel].rate.period_ms);
+  }
+  return err;
+}
+
+uint32_t adc_process_samples(void){
+  Adc_raw_sample_t batch[ADC_RING_BATCH];
+  uint32_t total = 0;
+  uint32_t n;
+
+  adc_ring_max_pending = MAX(adc_ring_max_pending, spsc_ring_count(&adc_ring));
+  do {
+    n = spsc_ring_pop_batch(&adc_ring, batch, ARRAY_SIZE(batch));
+    for (uint32_t i = 0; i < n; i++){
+      adc_process_sample(&batch[i]);
     }
+    total += n;
+  } while (n == ARRAY_SIZE(batch));
+  return total;
+}
+
+uint16_t adc_read_ch_data (uint8_t channel){
+  if (adc_sample_ch(channel) < 0){
+    return 0;
+  }
+  (void)adc_process_samples();
   return adc_a[channel].fbuf.data_media;
 }
 
-uint16_t adc_get_media (uint8_t channel, uint8_t size){
-  uint16_t media = 0;
-  uint16_t sat_value = 0;
-  if(channel < size){
-    if(adc_a[channel].status){
-      if(adc_a[channel].fbuf.count > 0){
-        uint16_t sum = 0;
-        for(uint8_t i = 0; i < adc_a[channel].fbuf.count; i++){
-          sat_value = (uint16_t)adc_a[channel].fbuf.data_set[i];
-          sum += sat_value; // Sum all values in the buffer
-        }
-        media = sum / adc_a[channel].fbuf.count; // Calculate the average
-      }else{
-        media = 0; // If no data, return zero
-      }
+uint32_t adc_get_sample_cyc(uint8_t channel){
+  return adc_a[channel].sample_cyc;
+}
+
+void adc_filter_set(uint8_t channel, adc_filter_t filter){
+  adc_filter[channel] = filter;
+}
+
+void adc_get_ring_stats(Adc_ring_stats_t *stats){
+  stats->overruns = adc_ring.overruns;
+  stats->pending = spsc_ring_count(&adc_ring);
+  stats->max_pending = adc_ring_max_pending;
+}
+
+uint16_t adc_get_media (uint8_t channel){
+  const Fifo_buf_t *fbuf = &adc_a[channel].fbuf;
+
+  if(fbuf->count == 0){
+    return 0; // If no data, return zero
+  }
+  // 32-bit accumulator: BUFFER_SIZE 16-bit samples cannot overflow it
+  uint32_t sum = 0;
+  for(uint8_t i = 0; i < fbuf->count; i++){
+    sum += fbuf->data_set[i]; // Sum all values in the buffer
+  }
+  return (uint16_t)(sum / fbuf->count); // Calculate the average
+}
+
+uint32_t adc_rate_update(uint8_t channel, adc_sample_t sample){
+  Adc_rate_t *rate = &adc_a[channel].rate;
+  const Adc_rate_cfg_t *cfg = &adc_rate_cfg[channel];
+  uint16_t slope = (sample > rate->last) ? sample - rate->last : rate->last - sample;
+  uint16_t media = adc_a[channel].fbuf.data_media;
+  uint16_t dev = (sample > media) ? sample - media : media - sample;
+
+  if(rate->conversions == 0 || slope > cfg->thr_mv || dev > cfg->thr_mv){
+    rate->period_ms = cfg->min_period_ms; // signal is moving, sample fast
+  }else{
+    rate->period_ms = MIN(rate->period_ms * 2, cfg->max_period_ms); // stable, back off
+  }
+  rate->last = sample;
+  rate->conversions++;
+  rate->next_ms = k_uptime_get_32() + rate_delay_ms(rate->period_ms);
+  return rate->period_ms;
+}
+
+bool adc_channel_is_due(uint8_t channel, uint32_t now_ms){
+  return (int32_t)(now_ms - adc_a[channel].rate.next_ms) >= 0;
+}
+
+uint32_t adc_next_due_ms(uint32_t now_ms){
+  uint32_t next = UINT32_MAX;
+  for(uint8_t i = 0; i < ADC_NUM_CHANNELS; i++){
+    int32_t left = (int32_t)(adc_a[i].rate.next_ms - now_ms);
+    next = MIN(next, (left > 0) ? (uint32_t)left : 0);
+  }
+  return next;
+}
+
+uint32_t adc_get_period_ms(uint8_t channel){
+  return adc_a[channel].rate.period_ms;
+}
+
+uint32_t adc_get_conversions(uint8_t channel){
+  return adc_a[channel].rate.conversions;
+}
+
+void adc_calib_request(void){
+  atomic_set(&calib_pending, 1);
+}
+
+void adc_get_perf(uint8_t channel, Adc_perf_t *perf){
+  *perf = adc_a[channel].perf;
+}
+
+void adc_get_quality(uint8_t channel, Adc_quality_t *quality){
+  *quality = adc_a[channel].quality;
+}
+
+bool adc_signal_usable(uint8_t channel){
+  return adc_a[channel].quality.sqi >= SQI_MIN_USABLE;
+}
+
+int adc_tune_set(uint8_t channel, const Adc_tune_t *tune){
+  if(tune->filter_len == 0 || tune->filter_len > adc_filter_len_max(channel) ||
+     tune->min_period_ms == 0 || tune->min_period_ms > tune->max_period_ms || tune->spike_limit == 0){
+    return -EINVAL;
+  }
+  Fifo_buf_t *fbuf = &adc_a[channel].fbuf;
+  Adc_rate_t *rate = &adc_a[channel].rate;
+  uint8_t length = tune->filter_len;
+
+  if(fbuf->count > length){
+    // Keep the newest samples, the media is recomputed on the shorter window
+    memmove(fbuf->data_set, &fbuf->data_set[fbuf->count - length], length * sizeof(adc_sample_t));
+    fbuf->count = length;
+  }
+  fbuf->length = length;
+  fbuf->data_media = adc_get_media(channel);
+
+  adc_rate_cfg[channel].min_period_ms = tune->min_period_ms;
+  adc_rate_cfg[channel].max_period_ms = tune->max_period_ms;
+  if(rate->period_ms < tune->min_period_ms || rate->period_ms > tune->max_period_ms){
+    uint32_t now = k_uptime_get_32();
+    rate->period_ms = CLAMP(rate->period_ms, tune->min_period_ms, tune->max_period_ms);
+    if((int32_t)(rate->next_ms - (now + rate_delay_ms(rate->period_ms))) > 0){
+      rate->next_ms = now + rate_delay_ms(rate->period_ms);
     }
   }
-  return media;
+
+  adc_glitch_cfg[channel].range_mv = tune->spike_range_mv;
+  adc_glitch_cfg[channel].limit = tune->spike_limit;
+  adc_a[channel].counter_spike = NO_ADC_SPIKE;
+  return 0;
+}
+
+void adc_tune_get(uint8_t channel, Adc_tune_t *tune){
+  tune->min_period_ms = adc_rate_cfg[channel].min_period_ms;
+  tune->max_period_ms = adc_rate_cfg[channel].max_period_ms;
+  tune->filter_len = adc_a[channel].fbuf.length;
+  tune->spike_range_mv = adc_glitch_cfg[channel].range_mv;
+  tune->spike_limit = adc_glitch_cfg[channel].limit;
 }
 
+uint8_t adc_filter_len_max(uint8_t channel){
+  return (adc_channels[channel].oversampling > 0) ? ADC_SW_AVG_OVERSAMPLED : BUFFER_SIZE;
+}
 
+void adc_report(void){
+  uint32_t now = k_uptime_get_32();
+  uint32_t fixed_per_hour = 3600000U / ADC_FIXED_PERIOD_MS;
+  Adc_ring_stats_t ring;
 
+  for (uint8_t ch = 0; ch < ADC_NUM_CHANNELS; ch++){
+    Adc_perf_t perf;
+    Adc_quality_t quality;
+    uint32_t conversions = adc_get_conversions(ch);
+    uint32_t per_hour = now ? (uint32_t)((uint64_t)conversions * 3600000U / now) : 0;
+    adc_get_perf(ch, &perf);
+    adc_get_quality(ch, &quality);
+    LOG("ADC ch%d: %u conversions/h (fixed rate %u/h)", ch, per_hour, fixed_per_hour);
+    LOG("ADC ch%d: %u cycles/conversion (max %u), noise %u.%02u mV, %u calibrations", ch, 
+        conversions ? perf.cycles_total / conversions : 0, perf.cycles_max,
+        perf.noise_q8 >> 8, ((perf.noise_q8 & 0xFF) * 100) >> 8, perf.calibrations);
+    LOG("ADC ch%d: SQI %u, %u/%u rejected, max %u consecutive", ch, quality.sqi, quality.rejects, 
+        quality.samples, quality.max_consec);
+  }
+  adc_get_ring_stats(&ring);
+  LOG("ADC ring: %u overruns, max %u/%u samples pending", ring.overruns, ring.max_pending, SPSC_RING_CAPACITY);
+}
@@ -0,0 +1,113 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file adc_replay.c
+ * @brief adc replay backend function definitions
+ *
+ * This implementation file feeds the captured samples to the ADC emulator: each 
+ * conversion returns the next captured sample of its channel, so every sample of the 
+ * capture goes through the processing chain once per loop, whatever ADC_REPLAY_SPEED. 
+ * The speed divides the sampling periods (adc_abstract.c), the replay clock is only 
+ * reported to compare the capture time fed with the uptime.
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include <zephyr/drivers/adc/adc_emul.h>
+#include "adc_replay.h"
+#include "adc_replay_data.h"
+
+typedef struct
+{
+  uint32_t cursor;  // next sample of the table to be checked
+  uint32_t ts_ms;   // capture time of the last value fed
+  uint16_t mv;      // last value fed for the channel
+  bool     present; // the capture has samples of the channel
+}Adc_replay_ch_t;
+
+static Adc_replay_ch_t replay_ch[ADC_NUM_CHANNELS];
+static Adc_replay_stats_t replay_stats;
+static uint32_t replay_start_ms;
+
+
+/***********************************************************
+ Static Function Definitions
+***********************************************************/
+/* Capture time expected at the replay speed, 64-bit: hours of uptime times the speed */
+static uint64_t replay_clock_ms(void){
+  return (uint64_t)(k_uptime_get_32() - replay_start_ms) * ADC_REPLAY_SPEED;
+}
+
+static uint32_t replay_next(uint8_t channel, uint32_t from){
+  while (from < ADC_REPLAY_NUM_SAMPLES && adc_replay_samples[from].channel != channel){
+    from++;
+  }
+  return from;
+}
+
+static int replay_value(const struct device *dev, unsigned int chan, void *data, uint32_t *result){
+  uint8_t channel = (uint8_t)(uintptr_t)data;
+  Adc_replay_ch_t *ch = &replay_ch[channel];
+
+  if (ch->present){
+    // The cursor only moves forward, each table entry is visited once per loop
+    uint32_t i = replay_next(channel, ch->cursor);
+    if (i == ADC_REPLAY_NUM_SAMPLES){
+      // End of the capture: restart from its first sample of the channel
+      i = replay_next(channel, 0);
+      if (channel == 0){
+        replay_stats.loops++;
+        adc_replay_report();
+      }
+    }
+    ch->mv = adc_replay_samples[i].mv;
+    ch->ts_ms = adc_replay_samples[i].ts_ms;
+    ch->cursor = i + 1;
+  }
+  replay_stats.fed++;
+  *result = ch->mv;
+  return 0;
+}
+
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+int adc_replay_init(void){
+  int err;
+  replay_start_ms = k_uptime_get_32();
+  for (uint8_t i = 0; i < ADC_NUM_CHANNELS; i++){
+    replay_ch[i].cursor = 0;
+    replay_ch[i].ts_ms = 0;
+    replay_ch[i].mv = ADC_REPLAY_DEFAULT_MV;
+    replay_ch[i].present = (replay_next(i, 0) < ADC_REPLAY_NUM_SAMPLES);
+    err = adc_emul_value_func_set(adc_channels[i].dev, adc_channels[i].channel_id, replay_value, (void *)(uintptr_t)i);
+    if (err < 0){
+      LOG_ADC("Replay not available on channel #%d (%d)\n", i, err);
+      return err;
+    }
+  }
+  LOG("ADC replay: %d samples, %d ms, speed x%d", ADC_REPLAY_NUM_SAMPLES, ADC_REPLAY_SPAN_MS, ADC_REPLAY_SPEED);
+  return 0;
+}
+
+void adc_replay_report(void){
+  LOG("ADC replay: %u conversions fed, %u loops, capture at %u ms (replay clock %llu ms), uptime %u ms",
+      replay_stats.fed, replay_stats.loops, replay_ch[0].ts_ms, (unsigned long long)replay_clock_ms(),
+      k_uptime_get_32() - replay_start_ms);
+}
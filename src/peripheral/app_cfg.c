@@ -0,0 +1,315 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file app_cfg.c
+ * @brief run time parameters function definitions
+ *
+ * app_cfg_set() runs in the context of the writer (bluetooth RX thread, shell, settings 
+ * load), the parameters are only copied under the lock there and applied by TASK_CONFIG.
+ * TASK_CONFIG also stores them, at most once every APP_CFG_SAVE_MIN_MS: a set written 
+ * before that is re-armed as a one-shot run and only the latest set reaches the flash.
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+
+#include "app_cfg.h"
+#include "adc_abstract.h"
+#include "task_sched.h"
+#include "energy.h"
+#include <string.h>
+#include <stdlib.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/settings/settings.h>
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
+
+#define APP_CFG_KEY   "cfg/params"
+
+static struct k_spinlock cfg_lock;
+static App_cfg_t cfg = {
+  .sample_min_ms = HR_RATE_MIN_MS,
+  .sample_max_ms = HR_RATE_MAX_MS,
+  .notify_period_ms = CONFIG_APP_BT_NOTIFY_PERIOD_MS,
+  .filter_len = ADC_FILTER_LEN,
+  .spike_range_mv = RANGE_MV,
+  .spike_limit = LIMIT_ADC_SPIKE,
+};
+static bool cfg_pending;        // staged set not applied yet
+static bool cfg_dirty;          // applied set not stored yet
+static uint32_t cfg_saved_ms;   // uptime of the last flash write
+static App_cfg_stats_t cfg_stats;
+
+
+/***********************************************************
+ Static Function Definitions
+***********************************************************/
+static bool cfg_check(const App_cfg_t *c){
+  return c->sample_min_ms >= APP_CFG_SAMPLE_MIN_MS && c->sample_min_ms <= c->sample_max_ms &&
+         c->sample_max_ms <= APP_CFG_SAMPLE_MAX_MS &&
+         c->notify_period_ms >= APP_CFG_NOTIFY_MIN_MS && c->notify_period_ms <= APP_CFG_NOTIFY_MAX_MS &&
+         c->filter_len >= 1 && c->filter_len <= app_cfg_filter_len_max() &&
+         c->spike_range_mv >= 1 && c->spike_range_mv <= APP_CFG_SPIKE_MAX_MV &&
+         c->spike_limit >= 1 && c->spike_limit <= APP_CFG_SPIKE_LIMIT_MAX;
+}
+
+/* Called with cfg_lock held, TASK_CONFIG is posted by the caller after the unlock */
+static int cfg_stage_locked(const App_cfg_t *c, bool save){
+  if (!cfg_check(c)){
+    cfg_stats.rejects++;
+    return -EINVAL;
+  }
+  cfg = *c;
+  cfg_pending = true;
+  if (save){
+    // A set still waiting for the flash is replaced, not written
+    cfg_stats.coalesced += cfg_dirty ? 1U : 0U;
+    cfg_dirty = true;
+  }
+  return 0;
+}
+
+static int cfg_stage(const App_cfg_t *c, bool save){
+  k_spinlock_key_t key = k_spin_lock(&cfg_lock);
+  int err = cfg_stage_locked(c, save);
+
+  k_spin_unlock(&cfg_lock, key);
+  if (err == 0){
+    task_sched_post(TASK_CONFIG);
+  }
+  return err;
+}
+
+static void cfg_update(const App_cfg_t *c){
+  for (uint8_t ch = 0; ch < ADC_NUM_CHANNELS; ch++){
+    Adc_tune_t tune;
+    adc_tune_get(ch, &tune);
+    if (ch == HR_CH){
+      tune.min_period_ms = c->sample_min_ms;
+      tune.max_period_ms = c->sample_max_ms;
+    }
+    tune.filter_len = c->filter_len;
+    tune.spike_range_mv = c->spike_range_mv;
+    tune.spike_limit = c->spike_limit;
+    (void)adc_tune_set(ch, &tune);
+  }
+  task_sched_set_period(TASK_NOTIFY, c->notify_period_ms);
+  LOG("Config: sample %u-%u ms, notify %u ms, window %u, spike %u mV x%u\n", c->sample_min_ms,
+      c->sample_max_ms, c->notify_period_ms, c->filter_len, c->spike_range_mv, c->spike_limit);
+}
+
+#if defined(CONFIG_SETTINGS)
+static int cfg_settings_set(const char *name, size_t len, settings_read_cb read_cb, void *cb_arg){
+  uint8_t buf[APP_CFG_WIRE_LEN];
+  App_cfg_t stored;
+  ssize_t rc;
+
+  // Stored in the wire format: independent of the struct layout and padding
+  if (!settings_name_steq(name, "params", NULL) || len != sizeof(buf)){
+    return -ENOENT;
+  }
+  rc = read_cb(cb_arg, buf, sizeof(buf));
+  if (rc < 0){
+    return rc;
+  }
+  if (app_cfg_decode(buf, (uint16_t)rc, &stored) != 0){
+    return -EINVAL;
+  }
+  // Restored parameters are applied but not written back
+  return cfg_stage(&stored, false);
+}
+
+static void cfg_store(void){
+  uint8_t buf[APP_CFG_WIRE_LEN];
+  uint32_t now = k_uptime_get_32();
+  uint32_t elapsed;
+  App_cfg_t c;
+  int err;
+  k_spinlock_key_t key = k_spin_lock(&cfg_lock);
+
+  if (!cfg_dirty){
+    k_spin_unlock(&cfg_lock, key);
+    return;
+  }
+  elapsed = now - cfg_saved_ms;
+  if (cfg_stats.saves && elapsed < APP_CFG_SAVE_MIN_MS){
+    k_spin_unlock(&cfg_lock, key);
+    task_sched_run_in(TASK_CONFIG, APP_CFG_SAVE_MIN_MS - elapsed);
+    return;
+  }
+  c = cfg;
+  cfg_dirty = false;
+  cfg_saved_ms = now;
+  k_spin_unlock(&cfg_lock, key);
+
+  app_cfg_encode(&c, buf);
+  err = settings_save_one(APP_CFG_KEY, buf, sizeof(buf));
+  energy_count(ENERGY_EVT_FLASH_WRITE);
+  key = k_spin_lock(&cfg_lock);
+  if (err){
+    // Retried with the next accepted set
+    cfg_dirty = true;
+  } else {
+    cfg_stats.saves++;
+  }
+  k_spin_unlock(&cfg_lock, key);
+  if (err){
+    LOG("Config not stored (err %d)\n", err);
+  }
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(app_cfg, "cfg", NULL, cfg_settings_set, NULL, NULL);
+#endif
+
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+void app_cfg_init(void){
+  k_spinlock_key_t key = k_spin_lock(&cfg_lock);
+  cfg.filter_len = MIN(cfg.filter_len, app_cfg_filter_len_max());
+  k_spin_unlock(&cfg_lock, key);
+}
+
+uint8_t app_cfg_filter_len_max(void){
+  uint8_t len = BUFFER_SIZE;
+
+  for (uint8_t ch = 0; ch < ADC_NUM_CHANNELS; ch++){
+    len = MIN(len, adc_filter_len_max(ch));
+  }
+  return len;
+}
+
+int app_cfg_set(const App_cfg_t *c){
+  return cfg_stage(c, true);
+}
+
+void app_cfg_get(App_cfg_t *c){
+  k_spinlock_key_t key = k_spin_lock(&cfg_lock);
+  *c = cfg;
+  k_spin_unlock(&cfg_lock, key);
+}
+
+void app_cfg_apply(void){
+  App_cfg_t c;
+  bool pending;
+  k_spinlock_key_t key = k_spin_lock(&cfg_lock);
+
+  c = cfg;
+  pending = cfg_pending;
+  cfg_pending = false;
+  cfg_stats.updates += pending ? 1U : 0U;
+  k_spin_unlock(&cfg_lock, key);
+
+  if (pending){
+    cfg_update(&c);
+  }
+#if defined(CONFIG_SETTINGS)
+  cfg_store();
+#endif
+}
+
+void app_cfg_encode(const App_cfg_t *c, uint8_t *buf){
+  sys_put_le16(c->sample_min_ms, buf);
+  sys_put_le16(c->sample_max_ms, buf + 2);
+  sys_put_le32(c->notify_period_ms, buf + 4);
+  buf[8] = c->filter_len;
+  sys_put_le16(c->spike_range_mv, buf + 9);
+  buf[11] = c->spike_limit;
+}
+
+int app_cfg_decode(const uint8_t *buf, uint16_t len, App_cfg_t *c){
+  if (len != APP_CFG_WIRE_LEN){
+    return -EMSGSIZE;
+  }
+  c->sample_min_ms = sys_get_le16(buf);
+  c->sample_max_ms = sys_get_le16(buf + 2);
+  c->notify_period_ms = sys_get_le32(buf + 4);
+  c->filter_len = buf[8];
+  c->spike_range_mv = sys_get_le16(buf + 9);
+  c->spike_limit = buf[11];
+  return 0;
+}
+
+void app_cfg_get_stats(App_cfg_stats_t *stats){
+  k_spinlock_key_t key = k_spin_lock(&cfg_lock);
+  *stats = cfg_stats;
+  k_spin_unlock(&cfg_lock, key);
+}
+
+
+#if defined(CONFIG_SHELL)
+static int cmd_cfg_show(const struct shell *sh, size_t argc, char **argv){
+  App_cfg_t c;
+  App_cfg_stats_t stats;
+
+  app_cfg_get(&c);
+  app_cfg_get_stats(&stats);
+  shell_print(sh, "sample_min_ms %u, sample_max_ms %u, notify_ms %u", c.sample_min_ms, c.sample_max_ms,
+              c.notify_period_ms);
+  shell_print(sh, "filter_len %u (max %u), spike_mv %u, spike_limit %u", c.filter_len, app_cfg_filter_len_max(),
+              c.spike_range_mv, c.spike_limit);
+  shell_print(sh, "%u updates, %u rejected, %u stored, %u replaced before storing", stats.updates,
+              stats.rejects, stats.saves, stats.coalesced);
+  return 0;
+}
+
+static int cmd_cfg_set(const struct shell *sh, size_t argc, char **argv){
+  App_cfg_t c;
+  uint32_t value = strtoul(argv[2], NULL, 0);
+  int err;
+  // Read, change and stage under the lock: a write from the control service in between is not lost
+  k_spinlock_key_t key = k_spin_lock(&cfg_lock);
+
+  c = cfg;
+  if (strcmp(argv[1], "sample_min_ms") == 0){
+    c.sample_min_ms = (uint16_t)MIN(value, UINT16_MAX);
+  } else if (strcmp(argv[1], "sample_max_ms") == 0){
+    c.sample_max_ms = (uint16_t)MIN(value, UINT16_MAX);
+  } else if (strcmp(argv[1], "notify_ms") == 0){
+    c.notify_period_ms = value;
+  } else if (strcmp(argv[1], "filter_len") == 0){
+    c.filter_len = (uint8_t)MIN(value, UINT8_MAX);
+  } else if (strcmp(argv[1], "spike_mv") == 0){
+    c.spike_range_mv = (uint16_t)MIN(value, UINT16_MAX);
+  } else if (strcmp(argv[1], "spike_limit") == 0){
+    c.spike_limit = (uint8_t)MIN(value, UINT8_MAX);
+  } else {
+    k_spin_unlock(&cfg_lock, key);
+    shell_error(sh, "parameters: sample_min_ms, sample_max_ms, notify_ms, filter_len, spike_mv, spike_limit");
+    return -EINVAL;
+  }
+  err = cfg_stage_locked(&c, true);
+  k_spin_unlock(&cfg_lock, key);
+  if (err != 0){
+    shell_error(sh, "value out of range");
+    return -EINVAL;
+  }
+  task_sched_post(TASK_CONFIG);
+  return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_cfg,
+  SHELL_CMD(show, NULL, "Print the run time parameters", cmd_cfg_show),
+  SHELL_CMD_ARG(set, NULL, "Set a parameter: set <name> <value>", cmd_cfg_set, 3, 0),
+  SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(cfg, &sub_cfg, "Run time parameters", NULL);
+#endif
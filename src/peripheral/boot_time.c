@@ -0,0 +1,74 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file boot_time.c
+ * @brief boot time instrumentation function definitions
+ *
+ * This implementation file stores the time of each boot milestone and prints
+ * a report once all milestones are reached.
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "boot_time.h"
+
+static uint32_t boot_evt_us[BOOT_EVT_NUM];
+static atomic_t boot_evt_mask = ATOMIC_INIT(0);    // milestones with their time stored
+static atomic_t boot_evt_claim = ATOMIC_INIT(0);   // milestones taken by a first caller
+
+static const char *const boot_evt_label[BOOT_EVT_NUM] = {
+  [BOOT_EVT_BT_ENABLE]    = "bt_enable requested",
+  [BOOT_EVT_PERIPH_READY] = "gpio/adc ready",
+  [BOOT_EVT_BT_READY]     = "bluetooth ready",
+  [BOOT_EVT_FIRST_ADV]    = "first advertisement",
+  [BOOT_EVT_FIRST_SAMPLE] = "first sample",
+};
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+void boot_time_mark(Boot_evt_t evt){
+  if(evt < BOOT_EVT_NUM){
+    // Milestones are marked from different threads, only the first caller stores the time. It 
+    // is published after the store: a reader that sees the bit of boot_evt_mask sees the time
+    if(!atomic_test_and_set_bit(&boot_evt_claim, evt)){
+      boot_evt_us[evt] = (uint32_t)k_ticks_to_us_floor64(k_uptime_ticks());
+      if(atomic_or(&boot_evt_mask, BIT(evt)) == (atomic_val_t)(BIT_MASK(BOOT_EVT_NUM) & ~BIT(evt))){
+        boot_time_report();
+      }
+    }
+  }
+}
+
+uint32_t boot_time_get_us(Boot_evt_t evt){
+  if(evt < BOOT_EVT_NUM && atomic_test_bit(&boot_evt_mask, evt)){
+    return boot_evt_us[evt];
+  }
+  return 0;
+}
+
+void boot_time_report(void){
+  LOG_BOOT("Boot report (time from reset):");
+  for(uint8_t i = 0; i < BOOT_EVT_NUM; i++){
+    if(atomic_test_bit(&boot_evt_mask, i)){
+      LOG_BOOT("  %-22s: %u us", boot_evt_label[i], boot_evt_us[i]);
+    }else{
+      LOG_BOOT("  %-22s: not reached", boot_evt_label[i]);
+    }
+  }
+}
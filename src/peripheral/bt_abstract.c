@@ -27,6 +27,11 @@
  */
 
 #include "bt_abstract.h"
+#include "bt_adv.h"
+#include <zephyr/settings/settings.h>
+
+static K_SEM_DEFINE(bt_ready_sem, 0, 1);
+static atomic_t bt_is_ready = ATOMIC_INIT(0);   // set by the enable callback, read by any thread
 
 /***********************************************************
  Static Function Definitions
@@ -49,27 +54,82 @@ static void auth_cancel(struct bt_conn *conn){
 	LOG("Pairing cancelled: %s\n", addr);
 }
 
+static void pairing_complete(struct bt_conn *conn, bool bonded){
+	if (bonded) {
+		bt_adv_peer_bonded(bt_conn_get_dst(conn));
+	}
+}
+
+static void pairing_failed(struct bt_conn *conn, enum bt_security_err reason){
+	LOG("Pairing failed (reason %d)\n", reason);
+}
+
+static void bond_deleted(uint8_t id, const bt_addr_le_t *peer){
+	bt_adv_peer_deleted(peer);
+}
+
 static struct bt_conn_auth_cb auth_cb_display = {
 	.cancel = auth_cancel,
 };
 
+static struct bt_conn_auth_info_cb auth_info_cb = {
+	.pairing_complete = pairing_complete,
+	.pairing_failed = pairing_failed,
+	.bond_deleted = bond_deleted,
+};
+
 BT_CONN_CB_DEFINE(conn_callbacks) = {
 	.connected = connected,
 	.disconnected = disconnected,
 };
 
+static void bt_enable_cb(int err){
+	if (err) {
+		LOG("Bluetooth init failed (err %d)\n", err);
+		return;
+	}
+	boot_time_mark(BOOT_EVT_BT_READY);
+	bt_ready();
+	bt_conn_auth_cb_reg();
+	atomic_set(&bt_is_ready, 1);
+	k_sem_give(&bt_ready_sem);
+}
+
 /***********************************************************
  Function Definitions
 ***********************************************************/
+int bt_init_async(void){
+	int err;
+	boot_time_mark(BOOT_EVT_BT_ENABLE);
+	err = bt_enable(bt_enable_cb);
+	if (err) {
+		LOG("Bluetooth init failed (err %d)\n", err);
+	}
+	return err;
+}
+
+bool bt_wait_ready(k_timeout_t timeout){
+	if (!atomic_get(&bt_is_ready)) {
+		// Keep the semaphore given so that next callers don't block
+		if (k_sem_take(&bt_ready_sem, timeout) != 0) {
+			return false;
+		}
+		k_sem_give(&bt_ready_sem);
+	}
+	return true;
+}
+
 void bt_ready(void){
 	int err;
 	LOG("Bluetooth initialized");
-	err = bt_le_adv_start(BT_LE_ADV_CONN_NAME, ad, ARRAY_SIZE(ad), NULL, 0);
-	if (err) {
-		LOG("Advertising failed to start (err %d)\n", err);
-		return;
+	// Bonds and last peer are needed before choosing the advertising mode
+	if (IS_ENABLED(CONFIG_SETTINGS)) {
+		err = settings_load();
+		if (err) {
+			LOG("Settings load failed (err %d)\n", err);
+		}
 	}
-	LOG("Advertising successfully started\n");
+	bt_adv_start();
 }
 
 void bt_conn_auth_cb_reg(){
@@ -80,6 +140,10 @@ void bt_conn_auth_cb_reg(){
 	} else {
 		LOG("Auth callbacks registered\n");
 	}
+	err = bt_conn_auth_info_cb_register(&auth_info_cb);
+	if (err) {
+		LOG("Failed to register auth info callbacks (err %d)\n", err);
+	}
 }
 
 
@@ -0,0 +1,490 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file bt_adv.c
+ * @brief advertising and bonded fast reconnect function definitions
+ *
+ * Advertising is started with BT_LE_ADV_OPT_ONE_TIME, every restart goes through 
+ * adv_work on the system workqueue: the connection object must be recycled before 
+ * a new connectable advertising set can be started. adv_step() is also scheduled at the end 
+ * of the fast burst and of the accept list window to restart the set with the next parameters.
+ * Advertising restarts only when the object of a disconnected link is recycled, not after 
+ * the release of other connection objects. The last peer is written to settings by adv_work 
+ * too: the bonding and security callbacks run in the bluetooth RX thread and only mark it.
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+
+#include "bt_adv.h"
+#include "bt_abstract.h"
+#include "energy.h"
+#include <string.h>
+#include <zephyr/settings/settings.h>
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
+
+#define BT_ADV_PEER_KEY     "app/peer"
+
+#define BT_ADV_OPTIONS      (BT_LE_ADV_OPT_CONNECTABLE | BT_LE_ADV_OPT_ONE_TIME | BT_LE_ADV_OPT_USE_NAME)
+#define BT_ADV_OPTIONS_ACCEPT_LIST (BT_ADV_OPTIONS | BT_LE_ADV_OPT_FILTER_CONN | BT_LE_ADV_OPT_FILTER_SCAN_REQ)
+
+/* Without the accept list (prj_minimal.conf) directed advertising falls back to open advertising */
+#define BT_ADV_UNDIRECTED   (IS_ENABLED(CONFIG_BT_FILTER_ACCEPT_LIST) ? BT_ADV_ACCEPT_LIST : BT_ADV_OPEN)
+
+#define BT_ADV_DELAY_US     5000    // mean of the 0-10 ms random advDelay added to each event
+#define BT_ADV_DIR_INT_US   3750    // high duty cycle directed advertising event interval
+#define BT_ADV_PDU_US(len)  ((16U + (len)) * 8U)  // 1M PHY: preamble, access address, header, AdvA, CRC
+#define BT_ADV_CHANNELS     3U
+
+static const Bt_adv_profile_t adv_profiles[BT_ADV_PROFILE_NUM] = {
+	[BT_ADV_PROFILE_LATENCY]  = {"latency",  60000, 32,  48,  244,  272},   // 20-30 ms, 152.5-170 ms
+	[BT_ADV_PROFILE_BALANCED] = {"balanced", 30000, 48,  96,  1600, 1920},  // 30-60 ms, 1-1.2 s
+	[BT_ADV_PROFILE_POWER]    = {"power",    10000, 160, 240, 3200, 3360},  // 100-150 ms, 2-2.1 s
+};
+
+BUILD_ASSERT(CONFIG_APP_BT_ADV_PROFILE < BT_ADV_PROFILE_NUM, "unknown advertising profile");
+
+static void adv_step(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(adv_work, adv_step);
+static K_MUTEX_DEFINE(adv_lock);
+
+static bt_addr_le_t last_peer;
+static bool has_peer = false;
+static bool is_connected = false;
+static bool restart_pending = false;          // link lost, restart once its object is recycled
+static bool peer_dirty = false;               // last peer changed, stored by adv_work
+static bool first_adv = true;
+static const Bt_adv_profile_t *adv_profile = &adv_profiles[CONFIG_APP_BT_ADV_PROFILE];
+static Bt_adv_mode_t adv_mode = BT_ADV_OPEN;  // mode of the running advertising set
+static Bt_adv_mode_t adv_next = BT_ADV_OPEN;  // mode started by next adv_step()
+static uint32_t restart_ms = 0;               // advertising restart, start of the fast burst
+static uint32_t mode_ms = 0;                  // start of the current advertising mode
+static uint32_t ad_len = 0;                   // advertising data length, for the airtime
+
+// Running advertising set, accounted when it stops
+static bool set_running = false;
+static Bt_adv_tier_t set_tier;
+static uint32_t set_start_ms;
+static uint32_t set_event_us;                 // interval + mean advDelay
+static uint32_t set_tx_us;                    // TX time of one event
+
+static Bt_adv_stats_t adv_stats;
+static uint64_t airtime_us = 0;
+static uint32_t disc_cyc = 0;
+static bool reconnect_pending = false;
+
+/***********************************************************
+ Static Function Definitions
+***********************************************************/
+#if defined(CONFIG_SETTINGS)
+static int peer_set(const char *name, size_t len, settings_read_cb read_cb, void *cb_arg){
+	ssize_t rc;
+
+	if (!settings_name_steq(name, "peer", NULL) || len != sizeof(last_peer)) {
+		return -ENOENT;
+	}
+	rc = read_cb(cb_arg, &last_peer, sizeof(last_peer));
+	if (rc < 0) {
+		return rc;
+	}
+	has_peer = true;
+	return 0;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(app_peer, "app", NULL, peer_set, NULL, NULL);
+#endif
+
+static void bond_count(const struct bt_bond_info *info, void *user_data){
+	uint8_t *count = user_data;
+
+	if (*count == 0 && !has_peer) {
+		// Last peer not stored: fall back to the first bond
+		bt_addr_le_copy(&last_peer, &info->addr);
+		has_peer = true;
+	}
+	(*count)++;
+}
+
+static void bond_accept(const struct bt_bond_info *info, void *user_data){
+	int *err = user_data;
+
+	if (*err == 0) {
+		*err = bt_le_filter_accept_list_add(&info->addr);
+	}
+}
+
+static uint8_t bonds_get(void){
+	uint8_t count = 0;
+
+	bt_foreach_bond(BT_ID_DEFAULT, bond_count, &count);
+	return count;
+}
+
+static int adv_accept_list(const struct bt_le_adv_param *param){
+	int err;
+
+	if (!IS_ENABLED(CONFIG_BT_FILTER_ACCEPT_LIST)) {
+		return -ENOTSUP;
+	}
+	err = bt_le_filter_accept_list_clear();
+	if (err) {
+		return err;
+	}
+	bt_foreach_bond(BT_ID_DEFAULT, bond_accept, &err);
+	if (err) {
+		return err;
+	}
+	return bt_le_adv_start(param, ad, ARRAY_SIZE(ad), NULL, 0);
+}
+
+static void adv_account(void){
+	uint32_t ms;
+	uint32_t events;
+
+	if (!set_running) {
+		return;
+	}
+	set_running = false;
+	ms = k_uptime_get_32() - set_start_ms;
+	events = (uint32_t)((uint64_t)ms * 1000U / set_event_us);
+	adv_stats.adv_ms[set_tier] += ms;
+	adv_stats.adv_events += events;
+	airtime_us += (uint64_t)events * set_tx_us;
+}
+
+static void adv_running(Bt_adv_tier_t tier, uint32_t event_us, uint32_t tx_us){
+	set_running = true;
+	set_tier = tier;
+	set_start_ms = k_uptime_get_32();
+	set_event_us = event_us;
+	set_tx_us = tx_us;
+}
+
+static void peer_store(void){
+	bt_addr_le_t peer;
+	bool store;
+	bool keep;
+	int err;
+
+	k_mutex_lock(&adv_lock, K_FOREVER);
+	store = peer_dirty;
+	keep = has_peer;
+	peer_dirty = false;
+	bt_addr_le_copy(&peer, &last_peer);
+	k_mutex_unlock(&adv_lock);
+
+	if (!store || !IS_ENABLED(CONFIG_SETTINGS)) {
+		return;
+	}
+	err = keep ? settings_save_one(BT_ADV_PEER_KEY, &peer, sizeof(peer)) : settings_delete(BT_ADV_PEER_KEY);
+	energy_count(ENERGY_EVT_FLASH_WRITE);
+	if (err) {
+		LOG("Last peer not stored (err %d)\n", err);
+	}
+}
+
+static void adv_step(struct k_work *work){
+	struct bt_le_adv_param param = BT_LE_ADV_PARAM_INIT(BT_ADV_OPTIONS, 0, 0, NULL);
+	Bt_adv_tier_t tier;
+	uint32_t now;
+	uint32_t next_ms = UINT32_MAX;  // next tier or mode change
+	int err = 0;
+
+	peer_store();
+	k_mutex_lock(&adv_lock, K_FOREVER);
+	if (is_connected) {
+		k_mutex_unlock(&adv_lock);
+		return;
+	}
+	bt_le_adv_stop();
+	adv_account();
+
+	if (!BT_ADV_FAST_RECONNECT || bonds_get() == 0) {
+		adv_next = BT_ADV_OPEN;
+	}
+	now = k_uptime_get_32();
+	if (adv_next != adv_mode) {
+		mode_ms = now;
+	}
+	adv_mode = adv_next;
+
+	if (now - restart_ms < adv_profile->fast_ms) {
+		tier = BT_ADV_TIER_FAST;
+		next_ms = adv_profile->fast_ms - (now - restart_ms);
+		param.interval_min = adv_profile->fast_int_min;
+		param.interval_max = adv_profile->fast_int_max;
+	} else {
+		tier = BT_ADV_TIER_SLOW;
+		param.interval_min = adv_profile->slow_int_min;
+		param.interval_max = adv_profile->slow_int_max;
+	}
+
+	switch (adv_mode) {
+	case BT_ADV_DIRECTED:
+		// High duty cycle, ends with a BT_HCI_ERR_ADV_TIMEOUT connected() callback
+		err = bt_le_adv_start(BT_LE_ADV_CONN_DIR(&last_peer), NULL, 0, NULL, 0);
+		adv_next = BT_ADV_UNDIRECTED;
+		next_ms = UINT32_MAX;
+		if (!err) {
+			adv_running(BT_ADV_TIER_FAST, BT_ADV_DIR_INT_US, BT_ADV_CHANNELS * BT_ADV_PDU_US(sizeof(bt_addr_t)));
+		}
+		break;
+	case BT_ADV_ACCEPT_LIST:
+		param.options = BT_ADV_OPTIONS_ACCEPT_LIST;
+		err = adv_accept_list(&param);
+		if (BT_ADV_ACCEPT_LIST_MS - (now - mode_ms) <= next_ms) {
+			next_ms = BT_ADV_ACCEPT_LIST_MS - (now - mode_ms);
+			adv_next = BT_ADV_OPEN;
+		}
+		break;
+	default:
+		err = bt_le_adv_start(&param, ad, ARRAY_SIZE(ad), NULL, 0);
+		break;
+	}
+
+	if (!err && adv_mode != BT_ADV_DIRECTED) {
+		adv_running(tier, (uint32_t)((param.interval_min + param.interval_max) / 2U) * 625U + BT_ADV_DELAY_US,
+			    BT_ADV_CHANNELS * BT_ADV_PDU_US(ad_len));
+		if (next_ms != UINT32_MAX) {
+			k_work_schedule(&adv_work, K_MSEC(next_ms));
+		}
+	} else if (err && adv_mode != BT_ADV_OPEN) {
+		adv_next = BT_ADV_OPEN;
+		k_work_schedule(&adv_work, K_NO_WAIT);
+	}
+	k_mutex_unlock(&adv_lock);
+
+	if (err) {
+		LOG("Advertising mode %d failed to start (err %d)\n", adv_mode, err);
+		return;
+	}
+	if (first_adv) {
+		first_adv = false;
+		boot_time_mark(BOOT_EVT_FIRST_ADV);
+	}
+	LOG("Advertising started (mode %d, %s tier)\n", adv_mode, tier == BT_ADV_TIER_FAST ? "fast" : "slow");
+}
+
+static void adv_restart(void){
+	k_mutex_lock(&adv_lock, K_FOREVER);
+	restart_ms = k_uptime_get_32();
+	adv_mode = BT_ADV_MODE_NUM;  // no set running, the next mode starts its window
+	adv_next = has_peer ? BT_ADV_DIRECTED : BT_ADV_UNDIRECTED;
+	k_mutex_unlock(&adv_lock);
+	k_work_reschedule(&adv_work, K_NO_WAIT);
+}
+
+static void adv_connected(struct bt_conn *conn, uint8_t err){
+	uint32_t ms;
+
+	if (err == BT_HCI_ERR_ADV_TIMEOUT) {
+		// Directed advertising expired without the peer
+		k_work_reschedule(&adv_work, K_NO_WAIT);
+		return;
+	}
+	if (err) {
+		adv_restart();
+		return;
+	}
+	k_work_cancel_delayable(&adv_work);
+	k_mutex_lock(&adv_lock, K_FOREVER);
+	is_connected = true;
+	adv_account();
+	ms = k_uptime_get_32() - restart_ms;
+	adv_stats.connections[adv_mode]++;
+	adv_stats.connects++;
+	adv_stats.ttc_last_ms = ms;
+	adv_stats.ttc_max_ms = MAX(adv_stats.ttc_max_ms, ms);
+	adv_stats.ttc_sum_ms += ms;
+	k_mutex_unlock(&adv_lock);
+}
+
+static void adv_disconnected(struct bt_conn *conn, uint8_t reason){
+	k_mutex_lock(&adv_lock, K_FOREVER);
+	is_connected = false;
+	restart_pending = true;
+	disc_cyc = k_cycle_get_32();
+	reconnect_pending = true;
+	k_mutex_unlock(&adv_lock);
+}
+
+static void adv_recycled(void){
+	bool restart;
+
+	// Objects released by other paths must not reset the advertising sequence
+	k_mutex_lock(&adv_lock, K_FOREVER);
+	restart = restart_pending && !is_connected;
+	restart_pending = false;
+	k_mutex_unlock(&adv_lock);
+	if (restart) {
+		adv_restart();
+	}
+}
+
+static void adv_security_changed(struct bt_conn *conn, bt_security_t level, enum bt_security_err err){
+	struct bt_conn_info info;
+
+	// An encrypted link with a bonded peer makes it the last peer
+	if (err || level < BT_SECURITY_L2 || bt_conn_get_info(conn, &info)) {
+		return;
+	}
+	if (info.le.dst && bt_addr_le_cmp(info.le.dst, &last_peer) && bonds_get()) {
+		bt_adv_peer_bonded(info.le.dst);
+	}
+}
+
+BT_CONN_CB_DEFINE(adv_callbacks) = {
+	.connected = adv_connected,
+	.disconnected = adv_disconnected,
+	.recycled = adv_recycled,
+	.security_changed = adv_security_changed,
+};
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+void bt_adv_start(void){
+	uint8_t bonds = bonds_get();
+
+	ad_len = 0;
+	for (uint8_t i = 0; i < ARRAY_SIZE(ad); i++) {
+		ad_len += 2U + ad[i].data_len;
+	}
+	LOG("Bonds %u, last peer %s, %s advertising profile\n", bonds, has_peer ? "stored" : "none",
+	    adv_profile->name);
+	// At boot the peer may still be around: directed advertising first as well
+	adv_restart();
+}
+
+void bt_adv_peer_bonded(const bt_addr_le_t *peer){
+	k_mutex_lock(&adv_lock, K_FOREVER);
+	bt_addr_le_copy(&last_peer, peer);
+	has_peer = true;
+	peer_dirty = true;
+	k_mutex_unlock(&adv_lock);
+	// While connected adv_work is idle: it only stores the peer. A pending mode change keeps its time.
+	k_work_schedule(&adv_work, K_NO_WAIT);
+}
+
+void bt_adv_peer_deleted(const bt_addr_le_t *peer){
+	k_mutex_lock(&adv_lock, K_FOREVER);
+	if (!has_peer || bt_addr_le_cmp(peer, &last_peer)) {
+		k_mutex_unlock(&adv_lock);
+		return;
+	}
+	has_peer = false;
+	peer_dirty = true;
+	k_mutex_unlock(&adv_lock);
+	k_work_schedule(&adv_work, K_NO_WAIT);
+}
+
+void bt_adv_notify_delivered(void){
+	uint32_t ms;
+
+	if (!reconnect_pending) {
+		return;
+	}
+	reconnect_pending = false;
+	ms = k_cyc_to_ms_floor32(k_cycle_get_32() - disc_cyc);
+	adv_stats.reconnects++;
+	adv_stats.last_ms = ms;
+	adv_stats.max_ms = MAX(adv_stats.max_ms, ms);
+	adv_stats.sum_ms += ms;
+}
+
+int bt_adv_profile_set(Bt_adv_profile_id_t id){
+	if (id >= BT_ADV_PROFILE_NUM) {
+		return -EINVAL;
+	}
+	k_mutex_lock(&adv_lock, K_FOREVER);
+	adv_profile = &adv_profiles[id];
+	// Restart undirected advertising in the same mode with the new intervals
+	if (set_running && adv_mode != BT_ADV_DIRECTED) {
+		adv_next = adv_mode;
+		k_work_reschedule(&adv_work, K_NO_WAIT);
+	}
+	k_mutex_unlock(&adv_lock);
+	return 0;
+}
+
+const Bt_adv_profile_t *bt_adv_profile_get(void){
+	return adv_profile;
+}
+
+void bt_adv_get_stats(Bt_adv_stats_t *stats){
+	k_mutex_lock(&adv_lock, K_FOREVER);
+	*stats = adv_stats;
+	stats->airtime_ms = (uint32_t)(airtime_us / 1000U);
+	if (set_running) {
+		// Running set up to now
+		stats->adv_ms[set_tier] += k_uptime_get_32() - set_start_ms;
+	}
+	k_mutex_unlock(&adv_lock);
+}
+
+void bt_adv_report(void){
+	Bt_adv_stats_t adv;
+
+	bt_adv_get_stats(&adv);
+	LOG("Reconnect: %u, last %u ms, mean %u ms, max %u ms (directed %u, accept list %u, open %u)", adv.reconnects,
+	    adv.last_ms, adv.reconnects ? adv.sum_ms / adv.reconnects : 0, adv.max_ms,
+	    adv.connections[BT_ADV_DIRECTED], adv.connections[BT_ADV_ACCEPT_LIST], adv.connections[BT_ADV_OPEN]);
+	LOG("Advertising (%s): time to connect mean %u ms, max %u ms, fast %u ms, slow %u ms, %u events, airtime %u ms",
+	    bt_adv_profile_get()->name, adv.connects ? adv.ttc_sum_ms / adv.connects : 0, adv.ttc_max_ms,
+	    adv.adv_ms[BT_ADV_TIER_FAST], adv.adv_ms[BT_ADV_TIER_SLOW], adv.adv_events, adv.airtime_ms);
+}
+
+#if defined(CONFIG_SHELL)
+static int cmd_adv_profile(const struct shell *sh, size_t argc, char **argv){
+	if (argc < 2) {
+		shell_print(sh, "%s", adv_profile->name);
+		return 0;
+	}
+	for (uint8_t i = 0; i < BT_ADV_PROFILE_NUM; i++) {
+		if (strcmp(argv[1], adv_profiles[i].name) == 0) {
+			return bt_adv_profile_set((Bt_adv_profile_id_t)i);
+		}
+	}
+	shell_error(sh, "profiles: latency, balanced, power");
+	return -EINVAL;
+}
+
+static int cmd_adv_show(const struct shell *sh, size_t argc, char **argv){
+	Bt_adv_stats_t stats;
+
+	bt_adv_get_stats(&stats);
+	shell_print(sh, "profile %s: fast %u ms, %u-%u / %u-%u (0.625 ms)", adv_profile->name, adv_profile->fast_ms,
+		    adv_profile->fast_int_min, adv_profile->fast_int_max, adv_profile->slow_int_min, adv_profile->slow_int_max);
+	shell_print(sh, "time to connect: %u, last %u ms, mean %u ms, max %u ms", stats.connects, stats.ttc_last_ms,
+		    stats.connects ? stats.ttc_sum_ms / stats.connects : 0, stats.ttc_max_ms);
+	shell_print(sh, "advertising: fast %u ms, slow %u ms, %u events, airtime %u ms", stats.adv_ms[BT_ADV_TIER_FAST],
+		    stats.adv_ms[BT_ADV_TIER_SLOW], stats.adv_events, stats.airtime_ms);
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_adv,
+	SHELL_CMD_ARG(profile, NULL, "Get or set the advertising profile (latency, balanced, power)", cmd_adv_profile, 1, 1),
+	SHELL_CMD(show, NULL, "Print advertising counters", cmd_adv_show),
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(adv, &sub_adv, "Advertising manager", NULL);
+#endif
@@ -0,0 +1,65 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file bt_ctrl.c
+ * @brief vendor control GATT service definition
+ *
+ * Writes are decoded and checked here, app_cfg applies them on the processing workqueue.
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include <zephyr/bluetooth/gatt.h>
+#include "bt_ctrl.h"
+#include "app_cfg.h"
+
+
+/***********************************************************
+ Static Function Definitions
+***********************************************************/
+static ssize_t read_config(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+			   void *buf, uint16_t len, uint16_t offset){
+	uint8_t value[APP_CFG_WIRE_LEN];
+	App_cfg_t cfg;
+
+	app_cfg_get(&cfg);
+	app_cfg_encode(&cfg, value);
+	return bt_gatt_attr_read(conn, attr, buf, len, offset, value, sizeof(value));
+}
+
+static ssize_t write_config(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+			    const void *buf, uint16_t len, uint16_t offset, uint8_t flags){
+	App_cfg_t cfg;
+
+	if (offset != 0) {
+		return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
+	}
+	if (app_cfg_decode(buf, len, &cfg) != 0) {
+		return BT_GATT_ERR(BT_ATT_ERR_INVALID_ATTRIBUTE_LEN);
+	}
+	if (app_cfg_set(&cfg) != 0) {
+		return BT_GATT_ERR(BT_ATT_ERR_VALUE_NOT_ALLOWED);
+	}
+	return len;
+}
+
+BT_GATT_SERVICE_DEFINE(ctrl_svc,
+	BT_GATT_PRIMARY_SERVICE(BT_UUID_CTRL),
+	BT_GATT_CHARACTERISTIC(BT_UUID_CTRL_CONFIG, BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE,
+			       BT_GATT_PERM_READ | BT_GATT_PERM_WRITE_ENCRYPT, read_config, write_config, NULL),
+);
@@ -0,0 +1,76 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file bt_diag.c
+ * @brief vendor diagnostics GATT service definition
+ *
+ * Values are encoded when read, long reads (offset > 0) are served from the same encoding.
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include <zephyr/bluetooth/gatt.h>
+#include <zephyr/sys/byteorder.h>
+#include "bt_diag.h"
+#include "latency_hist.h"
+#include "bt_notify.h"
+
+#define LAT_WORDS_PER_STAGE (3 + LAT_BUCKETS)
+
+
+/***********************************************************
+ Static Function Definitions
+***********************************************************/
+static ssize_t read_latency(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+			    void *buf, uint16_t len, uint16_t offset){
+	uint8_t value[LAT_STAGE_NUM * LAT_WORDS_PER_STAGE * sizeof(uint32_t)];
+	uint8_t *p = value;
+
+	for (uint8_t s = 0; s < LAT_STAGE_NUM; s++) {
+		Latency_hist_t hist;
+		latency_hist_get((Lat_stage_t)s, &hist);
+		sys_put_le32(hist.count, p);
+		sys_put_le32(hist.max_ms, p + 4);
+		sys_put_le32(hist.sum_ms, p + 8);
+		p += 12;
+		for (uint8_t b = 0; b < LAT_BUCKETS; b++) {
+			sys_put_le32(hist.buckets[b], p);
+			p += 4;
+		}
+	}
+	return bt_gatt_attr_read(conn, attr, buf, len, offset, value, sizeof(value));
+}
+
+static ssize_t read_tx(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+		       void *buf, uint16_t len, uint16_t offset){
+	Bt_notify_stats_t ntf;
+	uint8_t value[2 * sizeof(uint32_t)];
+
+	bt_notify_get_stats(&ntf);
+	sys_put_le32(ntf.not_queued, value);
+	sys_put_le32(ntf.errors, value + 4);
+	return bt_gatt_attr_read(conn, attr, buf, len, offset, value, sizeof(value));
+}
+
+BT_GATT_SERVICE_DEFINE(diag_svc,
+	BT_GATT_PRIMARY_SERVICE(BT_UUID_DIAG),
+	BT_GATT_CHARACTERISTIC(BT_UUID_DIAG_LATENCY, BT_GATT_CHRC_READ,
+			       BT_GATT_PERM_READ, read_latency, NULL, NULL),
+	BT_GATT_CHARACTERISTIC(BT_UUID_DIAG_TX, BT_GATT_CHRC_READ,
+			       BT_GATT_PERM_READ, read_tx, NULL, NULL),
+);
@@ -0,0 +1,397 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file bt_notify.c
+ * @brief grouped notification path function definitions
+ *
+ * The flush is done per connection with only the values the peer subscribed: a value without 
+ * subscribers would fail and stop the following ones.
+ *
+ * All the values of a call share the same sent callback and argument (a TX record): the stack 
+ * only merges values with the same callback in a Multiple Handle Value Notification, and calls 
+ * it once per value. The record gives back one credit per call and closes the heart rate 
+ * latency stamp when its last value is sent. Credits still out at a disconnection are reset. 
+ * The callback time also feeds the connection event estimate (bt_sync.h).
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include <string.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/uuid.h>
+#include <zephyr/bluetooth/services/hrs.h>
+#include "bt_notify.h"
+#include "latency_hist.h"
+#include "bt_adv.h"
+#include "bt_sync.h"
+
+/* Heart rate service of subsys/bluetooth/services/hrs.c, attrs[1] is the measurement */
+extern const struct bt_gatt_service_static hrs_svc;
+
+#define HRS_FLAG_SENSOR_CONTACT 0x06 // uint8 format, sensor contact supported and detected
+#define HRS_MEAS_LEN            2
+
+BUILD_ASSERT(BT_NOTIFY_TX_CREDITS > 0, "no TX buffer with callback");
+
+typedef struct
+{
+  const struct bt_gatt_attr *attr;
+  uint16_t  len;
+  bool      stamped;    // heart rate measurement with a latency stamp
+  uint32_t  stamp_cyc;
+  uint8_t   data[BT_NOTIFY_MAX_LEN];
+}Bt_notify_slot_t;
+
+typedef struct
+{
+  atomic_t  pending;    // values of the call waiting for the sent callback, 0 if free
+  struct bt_conn *conn; // connection of the call, compared only
+  bool      stamped;
+  uint32_t  stamp_cyc;
+}Bt_tx_rec_t;
+
+typedef struct
+{
+  uint8_t   sent;     // values sent to at least one peer
+  uint8_t   deferred; // values without TX credit for at least one peer
+  bool      grouped;  // more than one value sent to a peer in one call
+  uint32_t  copied;   // bytes copied by the stack into the PDUs
+  int       err;
+}Bt_flush_ctx_t;
+
+static K_MUTEX_DEFINE(notify_lock);
+static Bt_notify_slot_t slots[BT_NOTIFY_MAX_VALUES];
+static uint8_t slot_count;
+static Bt_notify_stats_t notify_stats;
+
+static Bt_tx_rec_t tx_recs[BT_NOTIFY_TX_CREDITS];
+static atomic_t tx_inflight;
+static uint8_t battery_level = 100U;
+
+
+/***********************************************************
+ Static Function Definitions
+***********************************************************/
+static void blvl_ccc_cfg_changed(const struct bt_gatt_attr *attr, uint16_t value){
+	LOG("Battery level notifications %s", (value == BT_GATT_CCC_NOTIFY) ? "enabled" : "disabled");
+}
+
+static ssize_t read_blvl(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+			 void *buf, uint16_t len, uint16_t offset){
+	uint8_t lvl8 = battery_level;
+	return bt_gatt_attr_read(conn, attr, buf, len, offset, &lvl8, sizeof(lvl8));
+}
+
+BT_GATT_SERVICE_DEFINE(app_bas_svc,
+	BT_GATT_PRIMARY_SERVICE(BT_UUID_BAS),
+	BT_GATT_CHARACTERISTIC(BT_UUID_BAS_BATTERY_LEVEL, BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY,
+			       BT_GATT_PERM_READ, read_blvl, NULL, &battery_level),
+	BT_GATT_CCC(blvl_ccc_cfg_changed, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE),
+);
+
+#if !defined(CONFIG_APP_BT_NOTIFY_STOCK)
+static void hrs_encode(const void *src, uint8_t *buf){
+	buf[0] = HRS_FLAG_SENSOR_CONTACT;
+	buf[1] = *(const uint8_t *)src;
+}
+#endif
+
+static void blvl_encode(const void *src, uint8_t *buf){
+	buf[0] = *(const uint8_t *)src;
+}
+
+/* Decrement a credit counter, it can't go below zero after a reset */
+static bool counter_put(atomic_t *counter){
+	atomic_val_t old = atomic_dec(counter);
+	if (old <= 0) {
+		atomic_inc(counter);
+		return false;
+	}
+	return true;
+}
+
+static void notify_sent(struct bt_conn *conn, void *user_data){
+	Bt_tx_rec_t *rec = user_data;
+	bool stamped = rec->stamped;
+	uint32_t stamp_cyc = rec->stamp_cyc;
+
+	bt_sync_sent();
+	(void)counter_put(&tx_inflight);
+	if (counter_put(&rec->pending) && atomic_get(&rec->pending) == 0 && stamped) {
+		latency_hist_add(LAT_STAGE_SENT, stamp_cyc, k_cycle_get_32());
+		bt_adv_notify_delivered();
+	}
+}
+
+static Bt_tx_rec_t *tx_rec_get(void){
+	for (uint8_t i = 0; i < BT_NOTIFY_TX_CREDITS; i++) {
+		if (atomic_get(&tx_recs[i].pending) == 0) {
+			tx_recs[i].stamped = false;
+			return &tx_recs[i];
+		}
+	}
+	return NULL;
+}
+
+static void flush_conn(struct bt_conn *conn, void *data){
+	Bt_flush_ctx_t *ctx = data;
+	struct bt_gatt_notify_params params[BT_NOTIFY_MAX_VALUES];
+	uint8_t slot_idx[BT_NOTIFY_MAX_VALUES];
+	atomic_val_t inflight = atomic_get(&tx_inflight);
+	uint8_t credits = (inflight < BT_NOTIFY_TX_CREDITS) ? (uint8_t)(BT_NOTIFY_TX_CREDITS - inflight) : 0U;
+	Bt_tx_rec_t *rec = tx_rec_get();
+	uint8_t stamped_idx = BT_NOTIFY_MAX_VALUES;
+	uint8_t queued = 0;
+	uint8_t n = 0;
+	int err = 0;
+
+	for (uint8_t i = 0; i < slot_count; i++) {
+		// Declaration attribute: the value attribute follows it
+		const struct bt_gatt_attr *value = slots[i].attr + 1;
+		if (!bt_gatt_is_subscribed(conn, slots[i].attr, BT_GATT_CCC_NOTIFY)) {
+			continue;
+		}
+		if (rec == NULL || n == credits) {
+			ctx->deferred |= BIT(i);
+			continue;
+		}
+		params[n] = (struct bt_gatt_notify_params){
+			.attr = value,
+			.data = slots[i].data,
+			.len = slots[i].len,
+			.func = notify_sent,
+			.user_data = rec,
+		};
+		if (slots[i].stamped) {
+			rec->stamped = true;
+			rec->stamp_cyc = slots[i].stamp_cyc;
+			stamped_idx = n;
+		}
+		slot_idx[n++] = i;
+	}
+	if (n == 0) {
+		return;
+	}
+	// Taken before sending, the sent callback can run before the call returns
+	rec->conn = conn;
+	atomic_set(&rec->pending, n);
+	inflight = atomic_add(&tx_inflight, n) + n;
+	notify_stats.inflight_max = MAX(notify_stats.inflight_max, (uint32_t)inflight);
+	// One call per value, so the values queued before an error are known: bt_gatt_notify_multiple()
+	// is the same loop and returns without telling them. With CONFIG_BT_GATT_NOTIFY_MULTIPLE the 
+	// stack still merges the values with the same callback for the capable peers.
+	for (; queued < n; queued++) {
+		err = bt_gatt_notify_cb(conn, &params[queued]);
+		if (err) {
+			break;
+		}
+		ctx->sent |= BIT(slot_idx[queued]);
+		ctx->copied += params[queued].len;
+	}
+#if defined(CONFIG_BT_GATT_NOTIFY_MULTIPLE)
+	ctx->grouped |= (queued > 1);
+#endif
+	if (err == 0) {
+		return;
+	}
+	// Values not queued give their credit back here, the queued ones in the sent callback. The 
+	// stamp is cleared before the record can complete, its last callback reads it.
+	if (stamped_idx >= queued) {
+		rec->stamped = false;
+	}
+	for (uint8_t i = queued; i < n; i++) {
+		(void)counter_put(&rec->pending);
+		(void)counter_put(&tx_inflight);
+		// Out of buffers: kept for the next flush as a value without credit
+		if (err == -ENOMEM) {
+			ctx->deferred |= BIT(slot_idx[i]);
+		} else {
+			notify_stats.not_queued++;
+		}
+	}
+	ctx->err = err;
+}
+
+static Bt_notify_slot_t *slot_get(const struct bt_gatt_attr *attr){
+	for (uint8_t i = 0; i < slot_count; i++) {
+		if (slots[i].attr == attr) {
+			return &slots[i];
+		}
+	}
+	return (slot_count < BT_NOTIFY_MAX_VALUES) ? &slots[slot_count++] : NULL;
+}
+
+static void notify_disconnected(struct bt_conn *conn, uint8_t reason){
+	// Sent callbacks of the values still queued on this connection are not called: their credits 
+	// come back here, the records of the other connections keep their accounting
+	for (uint8_t i = 0; i < BT_NOTIFY_TX_CREDITS; i++) {
+		if (tx_recs[i].conn != conn) {
+			continue;
+		}
+		for (atomic_val_t n = atomic_set(&tx_recs[i].pending, 0); n > 0; n--) {
+			(void)counter_put(&tx_inflight);
+		}
+		tx_recs[i].conn = NULL;
+	}
+}
+
+BT_CONN_CB_DEFINE(notify_callbacks) = {
+	.disconnected = notify_disconnected,
+};
+
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+int bt_notify_stage(const struct bt_gatt_attr *attr, const void *data, uint16_t len){
+	uint32_t start = k_cycle_get_32();
+	Bt_notify_slot_t *slot;
+
+	if (len > BT_NOTIFY_MAX_LEN) {
+		return -EINVAL;
+	}
+	k_mutex_lock(&notify_lock, K_FOREVER);
+	slot = slot_get(attr);
+	if (slot != NULL) {
+		*slot = (Bt_notify_slot_t){.attr = attr, .len = len};
+		memcpy(slot->data, data, len);
+		notify_stats.bytes_copied += len;
+	} else {
+		notify_stats.not_queued++;
+	}
+	notify_stats.cycles_total += k_cycle_get_32() - start;
+	k_mutex_unlock(&notify_lock);
+	return (slot != NULL) ? 0 : -ENOMEM;
+}
+
+int bt_notify_stage_enc(const struct bt_gatt_attr *attr, uint16_t len, Bt_notify_enc_t enc,
+			const void *src){
+	uint32_t start = k_cycle_get_32();
+	Bt_notify_slot_t *slot;
+
+	if (len > BT_NOTIFY_MAX_LEN) {
+		return -EINVAL;
+	}
+	k_mutex_lock(&notify_lock, K_FOREVER);
+	slot = slot_get(attr);
+	if (slot != NULL) {
+		slot->attr = attr;
+		slot->len = len;
+		slot->stamped = false;
+		enc(src, slot->data);
+		notify_stats.bytes_encoded += len;
+	} else {
+		notify_stats.not_queued++;
+	}
+	notify_stats.cycles_total += k_cycle_get_32() - start;
+	k_mutex_unlock(&notify_lock);
+	return (slot != NULL) ? 0 : -ENOMEM;
+}
+
+int bt_notify_stage_hrs(uint8_t heartrate, uint32_t sample_cyc){
+#if defined(CONFIG_APP_BT_NOTIFY_STOCK)
+	uint32_t start = k_cycle_get_32();
+	int err = bt_hrs_notify(heartrate);
+
+	k_mutex_lock(&notify_lock, K_FOREVER);
+	notify_stats.cycles_total += k_cycle_get_32() - start;
+	if (err == 0) {
+		// Encoded on the stack of bt_hrs_notify(), then copied into the PDU
+		latency_hist_add(LAT_STAGE_QUEUED, sample_cyc, k_cycle_get_32());
+		notify_stats.values++;
+		notify_stats.bytes_copied += HRS_MEAS_LEN;
+	} else {
+		notify_stats.not_queued++;
+	}
+	k_mutex_unlock(&notify_lock);
+	return err;
+#else
+	int err;
+
+	k_mutex_lock(&notify_lock, K_FOREVER);
+	err = bt_notify_stage_enc(&hrs_svc.attrs[1], HRS_MEAS_LEN, hrs_encode, &heartrate);
+	if (err == 0) {
+		Bt_notify_slot_t *slot = slot_get(&hrs_svc.attrs[1]);
+		slot->stamped = true;
+		slot->stamp_cyc = sample_cyc;
+	}
+	k_mutex_unlock(&notify_lock);
+	return err;
+#endif
+}
+
+int bt_notify_stage_bas(uint8_t level){
+	battery_level = MIN(level, 100U);
+	return bt_notify_stage_enc(&app_bas_svc.attrs[1], sizeof(battery_level), blvl_encode, &battery_level);
+}
+
+int bt_notify_flush(void){
+	uint32_t start = k_cycle_get_32();
+	Bt_flush_ctx_t ctx = {0};
+	uint8_t kept = 0;
+
+	k_mutex_lock(&notify_lock, K_FOREVER);
+	if (slot_count == 0) {
+		k_mutex_unlock(&notify_lock);
+		return 0;
+	}
+	bt_conn_foreach(BT_CONN_TYPE_LE, flush_conn, &ctx);
+	for (uint8_t i = 0; i < slot_count; i++) {
+		if (ctx.sent & BIT(i)) {
+			if (slots[i].stamped) {
+				latency_hist_add(LAT_STAGE_QUEUED, slots[i].stamp_cyc, k_cycle_get_32());
+			}
+			notify_stats.values++;
+		} else if (ctx.deferred & BIT(i)) {
+			// No credit: keep the value, a newer one staged before the next flush replaces it
+			slots[kept++] = slots[i];
+			notify_stats.deferred++;
+		}
+	}
+	notify_stats.flushes++;
+	notify_stats.grouped += ctx.grouped ? 1U : 0U;
+	notify_stats.errors += ctx.err ? 1U : 0U;
+	notify_stats.exhausted += (ctx.err == -ENOMEM) ? 1U : 0U;
+	notify_stats.bytes_copied += ctx.copied;
+	slot_count = kept;
+	notify_stats.cycles_total += k_cycle_get_32() - start;
+	k_mutex_unlock(&notify_lock);
+	return ctx.err;
+}
+
+int bt_hrs_notify_stamped(uint8_t heartrate, uint32_t sample_cyc){
+	int err = bt_notify_stage_hrs(heartrate, sample_cyc);
+	return err ? err : bt_notify_flush();
+}
+
+void bt_notify_get_stats(Bt_notify_stats_t *stats){
+	k_mutex_lock(&notify_lock, K_FOREVER);
+	*stats = notify_stats;
+	k_mutex_unlock(&notify_lock);
+}
+
+void bt_notify_report(void){
+	Bt_notify_stats_t ntf;
+
+	bt_notify_get_stats(&ntf);
+	LOG("Notify: %u flushes, %u values, %u grouped, %u errors, %u not queued", ntf.flushes, ntf.values, ntf.grouped,
+	    ntf.errors, ntf.not_queued);
+	LOG("Notify TX: %u deferred without credit, %u buffer exhausted, max %u/%u in flight, %u bytes encoded in place, "
+	    "%u bytes copied", ntf.deferred, ntf.exhausted, ntf.inflight_max, BT_NOTIFY_TX_CREDITS, ntf.bytes_encoded,
+	    ntf.bytes_copied);
+}
@@ -0,0 +1,172 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file bt_sync.c
+ * @brief connection event timing estimate function definitions
+ *
+ * Times are in us of the kernel tick counter (64-bit, no wrap). The sent callbacks come from 
+ * the bluetooth thread and the busy periods from the processing workqueue, the spinlock 
+ * keeps the estimate and the counters consistent.
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include <zephyr/bluetooth/conn.h>
+#include "bt_sync.h"
+
+#define BT_SYNC_UNIT_US   1250U   // connection interval unit
+
+static struct k_spinlock sync_lock;
+static Bt_sync_stats_t sync_stats;
+
+
+/***********************************************************
+ Static Function Definitions
+***********************************************************/
+static uint64_t now_us(void){
+	return k_ticks_to_us_floor64(k_uptime_ticks());
+}
+
+static void interval_set(uint16_t interval){
+	k_spinlock_key_t key = k_spin_lock(&sync_lock);
+
+	// New parameters: the anchor moves, the estimate starts again
+	sync_stats.interval_us = interval * BT_SYNC_UNIT_US;
+	sync_stats.samples = 0;
+	k_spin_unlock(&sync_lock, key);
+}
+
+static void sync_connected(struct bt_conn *conn, uint8_t err){
+	struct bt_conn_info info;
+
+	if (err == 0 && bt_conn_get_info(conn, &info) == 0) {
+		interval_set(info.le.interval);
+	}
+}
+
+static void sync_disconnected(struct bt_conn *conn, uint8_t reason){
+	interval_set(0);
+}
+
+static void sync_param_updated(struct bt_conn *conn, uint16_t interval, uint16_t latency, uint16_t timeout){
+	interval_set(interval);
+}
+
+BT_CONN_CB_DEFINE(sync_callbacks) = {
+	.connected = sync_connected,
+	.disconnected = sync_disconnected,
+	.le_param_updated = sync_param_updated,
+};
+
+/* Overlap of [start, start + len) with the windows [anchor + k * interval, + BT_SYNC_EVENT_US) */
+static uint64_t window_overlap(uint64_t start, uint64_t len, uint32_t anchor, uint32_t interval){
+	uint32_t win = MIN(BT_SYNC_EVENT_US, interval);
+	uint32_t a = (uint32_t)((start + interval - anchor) % interval);  // start after the last anchor
+	uint64_t overlap = (len / interval) * win;
+	uint32_t r = (uint32_t)(len % interval);
+
+	// Rest of the period: the current window and the next one
+	if (a < win) {
+		overlap += MIN(a + r, win) - a;
+	}
+	if (a + r > interval) {
+		overlap += MIN(a + r - interval, win);
+	}
+	return overlap;
+}
+
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+void bt_sync_sent(void){
+	uint64_t now = now_us();
+	k_spinlock_key_t key = k_spin_lock(&sync_lock);
+	uint32_t interval = sync_stats.interval_us;
+	uint32_t phase;
+	int32_t diff;
+
+	if (interval == 0) {
+		k_spin_unlock(&sync_lock, key);
+		return;
+	}
+	phase = (uint32_t)(now % interval);
+	if (sync_stats.samples == 0) {
+		sync_stats.anchor_us = phase;
+	} else {
+		// Signed phase difference in [-interval / 2, interval / 2)
+		diff = (int32_t)((phase + interval + interval / 2U - sync_stats.anchor_us) % interval) -
+		       (int32_t)(interval / 2U);
+		if (diff > 0) {
+			diff >>= BT_SYNC_DRIFT_SHIFT;
+		}
+		sync_stats.anchor_us = (uint32_t)((int32_t)sync_stats.anchor_us + diff + (int32_t)interval) % interval;
+	}
+	sync_stats.samples++;
+	k_spin_unlock(&sync_lock, key);
+}
+
+bool bt_sync_next_ms(uint32_t lead_us, uint32_t *delay_ms){
+	uint64_t now = now_us();
+	k_spinlock_key_t key = k_spin_lock(&sync_lock);
+	uint32_t interval = sync_stats.interval_us;
+	uint32_t target;
+	uint32_t wait;
+
+	if (interval == 0 || sync_stats.samples < BT_SYNC_MIN_SAMPLES) {
+		sync_stats.unaligned++;
+		k_spin_unlock(&sync_lock, key);
+		return false;
+	}
+	// Lead phase of the next event, one interval at least ahead of it if the lead is longer
+	target = (uint32_t)((sync_stats.anchor_us + interval - (lead_us % interval)) % interval);
+	wait = (uint32_t)((target + interval - (uint32_t)(now % interval)) % interval);
+	sync_stats.aligned++;
+	k_spin_unlock(&sync_lock, key);
+
+	// Rounded down: the run comes at most 1 ms earlier, inside the lead
+	*delay_ms = wait / 1000U;
+	return true;
+}
+
+void bt_sync_cpu_busy(uint32_t busy_cyc){
+	uint64_t len = k_cyc_to_us_floor64(busy_cyc);
+	uint64_t now = now_us();
+	k_spinlock_key_t key = k_spin_lock(&sync_lock);
+
+	if (sync_stats.interval_us && sync_stats.samples >= BT_SYNC_MIN_SAMPLES && len <= now) {
+		sync_stats.busy_us += len;
+		sync_stats.overlap_us += window_overlap(now - len, len, sync_stats.anchor_us, sync_stats.interval_us);
+	}
+	k_spin_unlock(&sync_lock, key);
+}
+
+void bt_sync_get_stats(Bt_sync_stats_t *stats){
+	k_spinlock_key_t key = k_spin_lock(&sync_lock);
+	*stats = sync_stats;
+	k_spin_unlock(&sync_lock, key);
+}
+
+void bt_sync_report(void){
+	Bt_sync_stats_t sync;
+
+	bt_sync_get_stats(&sync);
+	LOG("Conn sync: interval %u us, anchor phase %u us (%u sent callbacks), %u aligned / %u free running runs, "
+	    "cpu %u us busy, %u us on the radio windows", sync.interval_us, sync.anchor_us, sync.samples, sync.aligned,
+	    sync.unaligned, (uint32_t)sync.busy_us, (uint32_t)sync.overlap_us);
+}
@@ -0,0 +1,128 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file bt_trend.c
+ * @brief vendor trend GATT service definition
+ *
+ * Notifications go through the grouped notification path (bt_notify.h), a summary closed in 
+ * the same wakeup of a heart rate value is sent in the same flush. The records are encoded 
+ * in place in the staging slot. The HRV characteristic only exists with CONFIG_APP_HRV.
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include <zephyr/bluetooth/gatt.h>
+#include <zephyr/sys/byteorder.h>
+#include "bt_trend.h"
+#include "bt_notify.h"
+
+BUILD_ASSERT(BT_TREND_SUMMARY_LEN <= BT_NOTIFY_MAX_LEN, "summary does not fit a staged notification");
+BUILD_ASSERT(BT_TREND_HRV_LEN <= BT_NOTIFY_MAX_LEN, "HRV does not fit a staged notification");
+
+#if defined(CONFIG_APP_HRV)
+#define TREND_HRV_ATTRS \
+	BT_GATT_CHARACTERISTIC(BT_UUID_TREND_HRV, BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY, \
+			       BT_GATT_PERM_READ, read_hrv, NULL, NULL), \
+	BT_GATT_CCC(hrv_ccc_cfg_changed, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE),
+#else
+#define TREND_HRV_ATTRS
+#endif
+
+
+/***********************************************************
+ Static Function Definitions
+***********************************************************/
+static void summary_encode(const void *src, uint8_t *buf){
+	const Hr_agg_summary_t *s = src;
+
+	sys_put_le16(s->seq, buf);
+	sys_put_le16(s->window_s, buf + 2);
+	sys_put_le16(s->count, buf + 4);
+	buf[6] = s->min;
+	buf[7] = s->max;
+	sys_put_le16(s->mean_x10, buf + 8);
+	buf[10] = s->p10;
+	buf[11] = s->p50;
+	buf[12] = s->p90;
+}
+
+#if defined(CONFIG_APP_HRV)
+static void hrv_encode(const void *src, uint8_t *buf){
+	const Hrv_metrics_t *m = src;
+
+	sys_put_le16(m->beats, buf);
+	sys_put_le16(m->mean_rr_ms, buf + 2);
+	sys_put_le16(m->sdnn_x10, buf + 4);
+	sys_put_le16(m->rmssd_x10, buf + 6);
+	sys_put_le16(m->pnn50_x10, buf + 8);
+}
+#endif
+
+static void summary_ccc_cfg_changed(const struct bt_gatt_attr *attr, uint16_t value){
+	LOG("Trend summary notifications %s", (value == BT_GATT_CCC_NOTIFY) ? "enabled" : "disabled");
+}
+
+static ssize_t read_summary(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+			    void *buf, uint16_t len, uint16_t offset){
+	uint8_t value[BT_TREND_SUMMARY_LEN];
+	Hr_agg_summary_t summary;
+
+	if (!hr_agg_get_last(&summary)) {
+		return bt_gatt_attr_read(conn, attr, buf, len, offset, NULL, 0);
+	}
+	summary_encode(&summary, value);
+	return bt_gatt_attr_read(conn, attr, buf, len, offset, value, sizeof(value));
+}
+
+#if defined(CONFIG_APP_HRV)
+static void hrv_ccc_cfg_changed(const struct bt_gatt_attr *attr, uint16_t value){
+	LOG("Trend HRV notifications %s", (value == BT_GATT_CCC_NOTIFY) ? "enabled" : "disabled");
+}
+
+static ssize_t read_hrv(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+			void *buf, uint16_t len, uint16_t offset){
+	uint8_t value[BT_TREND_HRV_LEN];
+	Hrv_metrics_t metrics;
+
+	(void)hrv_get(&metrics);
+	hrv_encode(&metrics, value);
+	return bt_gatt_attr_read(conn, attr, buf, len, offset, value, sizeof(value));
+}
+#endif
+
+BT_GATT_SERVICE_DEFINE(trend_svc,
+	BT_GATT_PRIMARY_SERVICE(BT_UUID_TREND),
+	BT_GATT_CHARACTERISTIC(BT_UUID_TREND_SUMMARY, BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY,
+			       BT_GATT_PERM_READ, read_summary, NULL, NULL),
+	BT_GATT_CCC(summary_ccc_cfg_changed, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE),
+	TREND_HRV_ATTRS
+);
+
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+int bt_trend_stage_summary(const Hr_agg_summary_t *summary){
+	return bt_notify_stage_enc(&trend_svc.attrs[1], BT_TREND_SUMMARY_LEN, summary_encode, summary);
+}
+
+#if defined(CONFIG_APP_HRV)
+int bt_trend_stage_hrv(const Hrv_metrics_t *metrics){
+	return bt_notify_stage_enc(&trend_svc.attrs[4], BT_TREND_HRV_LEN, hrv_encode, metrics);
+}
+#endif
@@ -0,0 +1,191 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file energy.c
+ * @brief energy estimation function definitions
+ *
+ * Connection events are integrated over the connected time with the current connection 
+ * interval (peripheral latency not taken into account: every event is counted).
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+
+#include "energy.h"
+#include "adc_abstract.h"
+#include "bt_adv.h"
+#include "bt_notify.h"
+#include <zephyr/bluetooth/conn.h>
+
+static uint32_t cost_nc[ENERGY_EVT_NUM] = {
+  [ENERGY_EVT_ADC_CONV]    = ENERGY_NC_ADC_CONV,
+  [ENERGY_EVT_ADV]         = ENERGY_NC_ADV_EVENT,
+  [ENERGY_EVT_CONN]        = ENERGY_NC_CONN_EVENT,
+  [ENERGY_EVT_NOTIFY]      = ENERGY_NC_NOTIFY,
+  [ENERGY_EVT_FLASH_WRITE] = ENERGY_NC_FLASH_WRITE,
+};
+
+static const char *const energy_evt_name[ENERGY_EVT_NUM] = {
+  [ENERGY_EVT_ADC_CONV]    = "adc",
+  [ENERGY_EVT_ADV]         = "adv",
+  [ENERGY_EVT_CONN]        = "conn",
+  [ENERGY_EVT_NOTIFY]      = "notify",
+  [ENERGY_EVT_FLASH_WRITE] = "flash",
+};
+
+static atomic_t flash_writes = ATOMIC_INIT(0);
+
+/* Connection events: closed segments + open segment of the current link */
+static struct k_spinlock conn_lock;
+static uint32_t conn_events;
+static uint32_t conn_start_ms;
+static uint16_t conn_interval;    // 1.25 ms units, 0 when not connected
+
+
+/***********************************************************
+ Static Function Definitions
+***********************************************************/
+static uint32_t conn_segment(uint32_t now){
+  if (conn_interval == 0){
+    return 0;
+  }
+  return (uint32_t)((uint64_t)(now - conn_start_ms) * 4U / (conn_interval * 5U));
+}
+
+static void conn_interval_set(uint16_t interval){
+  uint32_t now = k_uptime_get_32();
+  k_spinlock_key_t key = k_spin_lock(&conn_lock);
+  conn_events += conn_segment(now);
+  conn_start_ms = now;
+  conn_interval = interval;
+  k_spin_unlock(&conn_lock, key);
+}
+
+static void energy_connected(struct bt_conn *conn, uint8_t err){
+  struct bt_conn_info info;
+  if (err == 0 && bt_conn_get_info(conn, &info) == 0){
+    conn_interval_set(info.le.interval);
+  }
+}
+
+static void energy_disconnected(struct bt_conn *conn, uint8_t reason){
+  conn_interval_set(0);
+}
+
+static void energy_param_updated(struct bt_conn *conn, uint16_t interval, uint16_t latency, uint16_t timeout){
+  conn_interval_set(interval);
+}
+
+BT_CONN_CB_DEFINE(energy_callbacks) = {
+  .connected = energy_connected,
+  .disconnected = energy_disconnected,
+  .le_param_updated = energy_param_updated,
+};
+
+static uint32_t cpu_active_ms(void){
+#if defined(CONFIG_SCHED_THREAD_USAGE_ALL)
+  k_thread_runtime_stats_t stats;
+  if (k_thread_runtime_stats_all_get(&stats) == 0){
+    return (uint32_t)k_cyc_to_ms_floor64(stats.execution_cycles - stats.idle_cycles);
+  }
+#endif
+  return 0;
+}
+
+#if defined(CONFIG_SCHED_THREAD_USAGE)
+// k_thread_foreach() walks the thread list kept by the thread monitor, empty without it
+BUILD_ASSERT(IS_ENABLED(CONFIG_THREAD_MONITOR), "per thread cpu time needs CONFIG_THREAD_MONITOR");
+
+static void thread_report(const struct k_thread *thread, void *user_data){
+  k_thread_runtime_stats_t stats;
+  const char *name = k_thread_name_get((k_tid_t)thread);
+  uint32_t ms;
+
+  if (k_thread_runtime_stats_get((k_tid_t)thread, &stats) != 0){
+    return;
+  }
+  ms = (uint32_t)k_cyc_to_ms_floor64(stats.execution_cycles);
+  LOG("Energy thread %s: %u ms active, %u uC", (name != NULL) ? name : "?", ms,
+      (uint32_t)((uint64_t)ms * ENERGY_UA_CPU_ACTIVE / 1000000U));
+}
+#endif
+
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+void energy_count(Energy_evt_t evt){
+  if (evt == ENERGY_EVT_FLASH_WRITE){
+    atomic_inc(&flash_writes);
+  }
+}
+
+void energy_cost_set(Energy_evt_t evt, uint32_t nc){
+  if (evt < ENERGY_EVT_NUM){
+    cost_nc[evt] = nc;
+  }
+}
+
+void energy_get(Energy_t *energy){
+  uint32_t now = k_uptime_get_32();
+  Bt_adv_stats_t adv;
+  Bt_notify_stats_t ntf;
+  k_spinlock_key_t key;
+  uint64_t total_nc;
+
+  bt_adv_get_stats(&adv);
+  bt_notify_get_stats(&ntf);
+  energy->elapsed_ms = now;
+  energy->cpu_active_ms = MIN(cpu_active_ms(), now);
+  energy->events[ENERGY_EVT_ADC_CONV] = 0;
+  for (uint8_t ch = 0; ch < ADC_NUM_CHANNELS; ch++){
+    energy->events[ENERGY_EVT_ADC_CONV] += adc_get_conversions(ch);
+  }
+  energy->events[ENERGY_EVT_ADV] = adv.adv_events;
+  key = k_spin_lock(&conn_lock);
+  energy->events[ENERGY_EVT_CONN] = conn_events + conn_segment(now);
+  k_spin_unlock(&conn_lock, key);
+  energy->events[ENERGY_EVT_NOTIFY] = ntf.values;
+  energy->events[ENERGY_EVT_FLASH_WRITE] = (uint32_t)atomic_get(&flash_writes);
+
+  total_nc = 0;
+  for (uint8_t e = 0; e < ENERGY_EVT_NUM; e++){
+    energy->charge_nc[e] = (uint64_t)energy->events[e] * cost_nc[e];
+    total_nc += energy->charge_nc[e];
+  }
+  // ms x uA = nC
+  energy->cpu_nc = (uint64_t)energy->cpu_active_ms * ENERGY_UA_CPU_ACTIVE;
+  energy->idle_nc = (uint64_t)(now - energy->cpu_active_ms) * ENERGY_UA_IDLE;
+  total_nc += energy->cpu_nc + energy->idle_nc;
+  energy->avg_ua = now ? (uint32_t)(total_nc / now) : 0;
+}
+
+void energy_report(void){
+  Energy_t energy;
+
+  energy_get(&energy);
+  LOG("Energy: %u uA average over %u s, cpu %u ms active (%u uC), idle %u uC", energy.avg_ua,
+      energy.elapsed_ms / 1000U, energy.cpu_active_ms, (uint32_t)(energy.cpu_nc / 1000U),
+      (uint32_t)(energy.idle_nc / 1000U));
+  for (uint8_t e = 0; e < ENERGY_EVT_NUM; e++){
+    LOG("Energy %s: %u events, %u uC", energy_evt_name[e], energy.events[e], (uint32_t)(energy.charge_nc[e] / 1000U));
+  }
+#if defined(CONFIG_SCHED_THREAD_USAGE)
+  k_thread_foreach(thread_report, NULL);
+#endif
+}
@@ -29,135 +29,225 @@
 
 uint8_t error_gpio = 0;
 
-static struct gpio_callback cb;
-
-Gpio_t gpio_a[NUM_GPIO_PERIP] = {
-	{
-		.active = true, 
-		.dev = DEVICE_DT_GET(DT_GPIO_CTLR(BTN1_NODE, gpios)), 
-		.pin =PIN_BTN1, 
-		.flags = FLAGS_BTN1, 
-		.direction = GPIO_INPUT, 
-		.value = false, 
-		.g_int = {
-			.active = false,
-			.port_config = GPIO_INT_EDGE_TO_ACTIVE,
-			.status = false,
-		},
-		.label = LABEL_BTN1,
-		.error = 0
-	}, //BTN1_INDEX
-	{
-		.active = true, 
-		.dev = DEVICE_DT_GET(DT_GPIO_CTLR(BTN2_NODE, gpios)), 
-		.pin =PIN_BTN2, 
-		.flags = FLAGS_BTN2, 
-		.direction = GPIO_INPUT, 
-		.value = false, 
-		.g_int = {
-			.active = false,
-			.port_config = GPIO_INT_EDGE_TO_ACTIVE,
-			.status = false,
-		},
-		.label = LABEL_BTN2,
-		.error = 0
-	}, //BTN1_INDEX
+typedef struct
+{
+	struct gpio_callback cb;
+	bool registered;
+}Gpio_port_cb_t;
 
+/* one callback for each gpio port, shared by all the pins of the port */
+static Gpio_port_cb_t port_cb[GPIO_NUM_PORTS];
+
+/* pin to channel lookup for each port, generated from devicetree: value is channel + 1 (0 means no handler) */
+#define GPIO_LUT_ENTRY(ch, node, ...)   [GPIO_DT_PORT(node)][DT_GPIO_PIN(node, gpios)] = (ch) + 1,
+
+static const uint8_t gpio_pin_lut[GPIO_NUM_PORTS][GPIO_PINS_PER_PORT] = {
+	GPIO_DT_CHANNELS(GPIO_LUT_ENTRY)
+};
+
+#define GPIO_COUNT(ch, node, ...)       + 1
+#define GPIO_PORT_RANGE(ch, node, ...)  && (GPIO_DT_PORT(node) < GPIO_DT_MAX_PINS)
+#define GPIO_PIN_RANGE(ch, node, ...)   && (DT_GPIO_PIN(node, gpios) < GPIO_DT_NGPIOS(node)) \
+					&& (GPIO_DT_NGPIOS(node) <= GPIO_DT_MAX_PINS)
+
+BUILD_ASSERT((0 GPIO_DT_CHANNELS(GPIO_COUNT)) == NUM_GPIO_PERIP, "every gpio channel needs a devicetree node");
+BUILD_ASSERT(1 GPIO_DT_CHANNELS(GPIO_PORT_RANGE), "gpio port out of range");
+BUILD_ASSERT(1 GPIO_DT_CHANNELS(GPIO_PIN_RANGE), "gpio pin out of range of its controller");
+
+/* Callbacks and lookup rows are indexed by port: all the channels of a port must be on the same 
+ * controller. The devicetree ordinals of the controllers of a port are equal when their AND 
+ * equals their OR (all ones: no channel on the port). */
+#define GPIO_PORT_ORD_AND(ch, node, p)  & (GPIO_DT_PORT(node) == (p) ? GPIO_DT_CTLR_ORD(node) : ~0U)
+#define GPIO_PORT_ORD_OR(ch, node, p)   | (GPIO_DT_PORT(node) == (p) ? GPIO_DT_CTLR_ORD(node) : 0U)
+#define GPIO_PORT_CHECK(p, ...)                                             \
+	BUILD_ASSERT((~0U GPIO_DT_CHANNELS(GPIO_PORT_ORD_AND, p)) == ~0U || \
+		     (~0U GPIO_DT_CHANNELS(GPIO_PORT_ORD_AND, p)) ==        \
+		     (0U GPIO_DT_CHANNELS(GPIO_PORT_ORD_OR, p)),            \
+		     "two gpio controllers on the same port index: give them distinct \"port\" properties")
+
+/* LISTIFY needs a literal count: every possible port index, the unused ones pass */
+LISTIFY(GPIO_DT_MAX_PINS, GPIO_PORT_CHECK, (;));
+
+/* interrupt events posted by the ISR, one bit for each channel */
+static atomic_t gpio_events = ATOMIC_INIT(0);
+
+static Gpio_isr_stats_t isr_stats;
+static Gpio_event_handler_t event_handler = NULL;
+
+/* devicetree configuration, constant: kept in flash */
+#define GPIO_DESC(ch, node, ...)                                  \
+	[ch] = {                                                  \
+		.dev = DEVICE_DT_GET(DT_GPIO_CTLR(node, gpios)),  \
+		.port = GPIO_DT_PORT(node),                       \
+		.pin = DT_GPIO_PIN(node, gpios),                  \
+		.flags = DT_GPIO_FLAGS(node, gpios) | GPIO_INPUT, \
+		.int_config = GPIO_INT_EDGE_TO_ACTIVE,            \
+		.label = DT_PROP(node, label),                    \
+	},
+
+static const Gpio_desc_t gpio_desc[NUM_GPIO_PERIP] = {
+	GPIO_DT_CHANNELS(GPIO_DESC)
 };
 
-void gpio_enable_interrupt(Gpio_t* gt, uint8_t channel, bool enable){
-	gt[channel].g_int.active = enable;
+/* run time state */
+static Gpio_t gpio_a[NUM_GPIO_PERIP];
+
+static void interrupt_callback(const struct device *dev, struct gpio_callback *cb, uint32_t pins){
+	uint32_t start = k_cycle_get_32();
+	Gpio_port_cb_t *port = CONTAINER_OF(cb, Gpio_port_cb_t, cb);
+	const uint8_t *lut = gpio_pin_lut[port - port_cb];
+	uint32_t cycles;
+	bool posted = false;
+
+	pins &= cb->pin_mask;
+	while (pins) {
+		uint8_t pin = find_lsb_set(pins) - 1;
+		pins &= ~BIT(pin);
+		if (lut[pin]) {
+			atomic_set_bit(&gpio_events, lut[pin] - 1);
+			posted = true;
+		}
+		isr_stats.pins++;
+	}
+	if (posted && event_handler != NULL) {
+		event_handler();
+	}
+
+	cycles = k_cycle_get_32() - start;
+	isr_stats.count++;
+	isr_stats.total_cycles += cycles;
+	if (cycles > isr_stats.max_cycles) {
+		isr_stats.max_cycles = cycles;
+	}
 }
 
-void gpio_enable(Gpio_t* gt, uint8_t channel, bool enable){
-	gt[channel].active = enable;
+/* Turn on the interrupt of a channel in hardware and add its pin to the port callback */
+static void gpio_arm_interrupt(uint8_t channel){
+	const Gpio_desc_t *desc = &gpio_desc[channel];
+	Gpio_port_cb_t *port = &port_cb[desc->port];
+
+	gpio_pin_interrupt_configure(desc->dev, desc->pin, desc->int_config);
+	if (!port->registered) {
+		// First pin of the port: the callback is added once and shared by next pins
+		gpio_init_callback(&port->cb, interrupt_callback, BIT(desc->pin));
+		gpio_add_callback(desc->dev, &port->cb);
+		port->registered = true;
+	} else {
+		port->cb.pin_mask |= BIT(desc->pin);
+	}
 }
 
-void interrupt_callback(const struct device *dev, struct gpio_callback *cb, uint32_t pins){
-	for (int i = 0; i < NUM_GPIO_PERIP; i++) {
-		if (pins & BIT(gpio_a[i].pin)) {
-			gpio_a[i].g_int.status = true;
-			LOG("GPIO interrupt triggered for %s\n", gpio_a[i].label);
-    	}
+void gpio_enable_interrupt(uint8_t channel, bool enable){
+	const Gpio_desc_t *desc;
+	Gpio_port_cb_t *port;
+	bool armed;
+
+	__ASSERT_NO_MSG(channel < NUM_GPIO_PERIP);
+	desc = &gpio_desc[channel];
+	port = &port_cb[desc->port];
+	gpio_a[channel].int_active = enable;
+	armed = port->registered && (port->cb.pin_mask & BIT(desc->pin));
+	// Once configured, a disabled pin is turned off in hardware: events never need an enable check
+	if (!enable && armed) {
+		gpio_pin_interrupt_configure(desc->dev, desc->pin, GPIO_INT_DISABLE);
+		port->cb.pin_mask &= ~BIT(desc->pin);
+		atomic_clear_bit(&gpio_events, channel);
+	} else if (enable && !armed && gpio_a[channel].active && gpio_a[channel].int_configured) {
+		gpio_arm_interrupt(channel);
 	}
 }
 
+void gpio_enable(uint8_t channel, bool enable){
+	__ASSERT_NO_MSG(channel < NUM_GPIO_PERIP);
+	gpio_a[channel].active = enable;
+	if (!enable) {
+		gpio_enable_interrupt(channel, false);
+	}
+}
 
-uint32_t get_gpio_pin_interrupt_config(Gpio_t* gt, uint8_t size){
+uint32_t get_gpio_pin_interrupt_config(void){
 	uint32_t pin_list = 0;
-	for (int i = 0; i < size; i++) {
-		if (gt[i].active && gt[i].g_int.active) {
-			pin_list |= BIT(gt[i].pin);
+	for (int i = 0; i < NUM_GPIO_PERIP; i++) {
+		if (gpio_a[i].active && gpio_a[i].int_active) {
+			pin_list |= BIT(gpio_desc[i].pin);
 		}
 	}
 	return pin_list;
 }
 
-void gpio_init(Gpio_t* gt, uint8_t channel, uint8_t size){
-	if (channel < size) {
-		if (gt[channel].active){
-			if (!device_is_ready(gt[channel].dev)){
-				LOG("Error: GPIO device %s is not ready\n", gt[channel].label);
-				gt[channel].error = ERROR_GPIO_INIT;
-			}else			{
-				LOG("GPIO device %s is ready\n", gt[channel].label);
-				gt[channel].error = 0;
-			}
-		}else{
-			LOG("GPIO device %s is not active\n", gt[channel].label);
-			gt[channel].error = ERROR_GPIO_INIT;
+const char *get_gpio_label(uint8_t channel){
+	return gpio_desc[channel].label;
+}
+
+void gpio_init(uint8_t channel){
+	const Gpio_desc_t *desc = &gpio_desc[channel];
+
+	__ASSERT_NO_MSG(channel < NUM_GPIO_PERIP);
+	if (gpio_a[channel].active){
+		if (!device_is_ready(desc->dev)){
+			LOG("Error: GPIO device %s is not ready\n", desc->label);
+			gpio_a[channel].error = ERROR_GPIO_INIT;
+		}else			{
+			LOG("GPIO device %s is ready\n", desc->label);
+			gpio_a[channel].error = 0;
 		}
 	}else{
-		LOG("Error: Channel index out of bounds\n");
-		return;	
-	}	
+		LOG("GPIO device %s is not active\n", desc->label);
+		gpio_a[channel].error = ERROR_GPIO_INIT;
+	}
 }
 
-void gpio_configure(Gpio_t* gt, uint8_t channel,  uint8_t size){
+void gpio_configure(uint8_t channel){
+	const Gpio_desc_t *desc = &gpio_desc[channel];
 	int ret;
-	if (channel < size) {
-		if (gt[channel].active){
-			ret = gpio_pin_configure(gt[channel].dev, gt[channel].pin, gt[channel].flags | gt[channel].direction);
-			if (ret < 0){
-				LOG("Error: GPIO device %s cannot be configured\n", gt[channel].label);
-				gt[channel].error = ERROR_GPIO_INIT;
-			}else{
-				LOG("GPIO device %s configured successfully\n", gt[channel].label);
-				gt[channel].error = 0;
-			}
+
+	__ASSERT_NO_MSG(channel < NUM_GPIO_PERIP);
+	if (gpio_a[channel].active){
+		ret = gpio_pin_configure(desc->dev, desc->pin, desc->flags);
+		if (ret < 0){
+			LOG("Error: GPIO device %s cannot be configured\n", desc->label);
+			gpio_a[channel].error = ERROR_GPIO_INIT;
+		}else{
+			LOG("GPIO device %s configured successfully\n", desc->label);
+			gpio_a[channel].error = 0;
 		}
 	}
 }
 
-void gpio_configure_interrupt(Gpio_t* gt, uint8_t channel, uint8_t size){
-	if (channel < size) {
-		if (gt[channel].active){
-			if(!gt[channel].g_int.active){
-				LOG("Error: GPIO interrupt for %s is not active\n", gt[channel].label);
-				return;
-			}else{
-				LOG("GPIO interrupt for %s is active\n", gt[channel].label);
-				gpio_pin_interrupt_configure(gt[channel].dev, gt[channel].pin,  gt[channel].g_int.port_config);
-				gpio_init_callback(&cb, interrupt_callback, get_gpio_pin_interrupt_config(gt, size));
-				gpio_add_callback(gt[channel].dev, &cb);
-			}	
-		}
-	}else {
-		LOG("Error: Channel index out of bounds\n");
-		return;	
+void gpio_configure_interrupt(uint8_t channel){
+	const Gpio_desc_t *desc = &gpio_desc[channel];
+
+	__ASSERT_NO_MSG(channel < NUM_GPIO_PERIP);
+	if (gpio_a[channel].active){
+		if(!gpio_a[channel].int_active){
+			LOG("Error: GPIO interrupt for %s is not active\n", desc->label);
+			return;
+		}else{
+			LOG("GPIO interrupt for %s is active\n", desc->label);
+			gpio_arm_interrupt(channel);
+			gpio_a[channel].int_configured = true;
+		}	
 	}
 }
 
-void reset_gpio_interrupt(Gpio_t* gt, uint8_t channel){
-	if (gt[channel].active && gt[channel].g_int.active){
-		gt[channel].g_int.status = false;
-	}
+void reset_gpio_interrupt(uint8_t channel){
+	atomic_clear_bit(&gpio_events, channel);
 }
 
-bool get_gpio_interrupt_status(Gpio_t* gt, uint8_t channel){
-	if (gt[channel].active && gt[channel].g_int.active){
-		return gt[channel].g_int.status;
-	}else{
-		return false;
-	}
+bool get_gpio_interrupt_status(uint8_t channel){
+	return atomic_test_bit(&gpio_events, channel);
+}
+
+bool take_gpio_interrupt(uint8_t channel){
+	return atomic_test_and_clear_bit(&gpio_events, channel);
+}
+
+void get_gpio_isr_stats(Gpio_isr_stats_t *stats){
+	unsigned int key = irq_lock();
+	*stats = isr_stats;
+	irq_unlock(key);
+}
+
+void gpio_set_event_handler(Gpio_event_handler_t handler){
+	event_handler = handler;
 }
\ No newline at end of file
@@ -0,0 +1,219 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file hr_agg.c
+ * @brief heart rate windowed aggregation function definitions
+ *
+ * The current window is only touched by the processing workqueue (hr_agg_add(), hr_agg_close()), 
+ * the lock protects the last summary and the statistics read by other threads.
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+
+#include "hr_agg.h"
+#include "task_sched.h"
+#include <string.h>
+#include <stdlib.h>
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
+
+typedef struct
+{
+  uint64_t  sum;                    // bpm x ms
+  uint32_t  weight_ms;              // time covered by the values of the window
+  uint32_t  count;
+  uint8_t   min;
+  uint8_t   max;
+  uint32_t  hist[HR_AGG_BUCKETS];   // ms per bucket
+}Hr_agg_window_t;
+
+BUILD_ASSERT(HR_AGG_MIN_BPM + HR_AGG_BUCKETS * HR_AGG_BUCKET_BPM <= UINT8_MAX + 1, "histogram beyond 8-bit bpm");
+BUILD_ASSERT(CONFIG_APP_HR_AGG_WINDOW_MS >= HR_AGG_WINDOW_MIN_MS && CONFIG_APP_HR_AGG_WINDOW_MS <= HR_AGG_WINDOW_MAX_MS,
+             "aggregation window out of range");
+
+static Hr_agg_window_t win = {.min = UINT8_MAX};
+static uint32_t window_ms = CONFIG_APP_HR_AGG_WINDOW_MS;
+static uint16_t window_seq;
+
+static struct k_spinlock agg_lock;
+static Hr_agg_summary_t last;
+static bool has_last;
+static Hr_agg_stats_t agg_stats;
+
+
+/***********************************************************
+ Static Function Definitions
+***********************************************************/
+/* Middle of the bucket holding the value of the given rank (1..count) */
+static uint8_t agg_percentile(uint32_t rank){
+  uint32_t acc = 0;
+  uint8_t b;
+
+  for (b = 0; b < HR_AGG_BUCKETS - 1; b++){
+    acc += win.hist[b];
+    if (acc >= rank){
+      break;
+    }
+  }
+  return (uint8_t)CLAMP(HR_AGG_MIN_BPM + b * HR_AGG_BUCKET_BPM + HR_AGG_BUCKET_BPM / 2, win.min, win.max);
+}
+
+/* Weight (ms) up to the given percentile: the window max plus a clamped period fits 32 bits */
+static uint32_t agg_rank(uint8_t pct){
+  return MAX((win.weight_ms * pct + 99U) / 100U, 1U);
+}
+
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+void hr_agg_add(uint8_t bpm, uint32_t weight_ms){
+  uint32_t start = k_cycle_get_32();
+  uint32_t b = (bpm > HR_AGG_MIN_BPM) ? (uint32_t)(bpm - HR_AGG_MIN_BPM) / HR_AGG_BUCKET_BPM : 0;
+  uint32_t w = CLAMP(weight_ms, 1U, window_ms);
+  uint32_t cycles;
+
+  win.count++;
+  win.weight_ms += w;
+  win.sum += (uint64_t)bpm * w;
+  win.min = MIN(win.min, bpm);
+  win.max = MAX(win.max, bpm);
+  win.hist[MIN(b, HR_AGG_BUCKETS - 1)] += w;
+
+  cycles = k_cycle_get_32() - start;
+  k_spinlock_key_t key = k_spin_lock(&agg_lock);
+  agg_stats.samples++;
+  agg_stats.cycles_total += cycles;
+  agg_stats.cycles_max = MAX(agg_stats.cycles_max, cycles);
+  k_spin_unlock(&agg_lock, key);
+}
+
+void hr_agg_skip(void){
+  k_spinlock_key_t key = k_spin_lock(&agg_lock);
+  agg_stats.skipped++;
+  k_spin_unlock(&agg_lock, key);
+}
+
+bool hr_agg_close(Hr_agg_summary_t *summary){
+  bool filled = (win.count > 0);
+  k_spinlock_key_t key;
+
+  window_seq++;
+  if (filled){
+    *summary = (Hr_agg_summary_t){
+      .seq = window_seq,
+      .window_s = (uint16_t)(window_ms / 1000U),
+      .count = (uint16_t)MIN(win.count, UINT16_MAX),
+      .min = win.min,
+      .max = win.max,
+      .mean_x10 = (uint16_t)((win.sum * 10U + win.weight_ms / 2U) / win.weight_ms),
+      .p10 = agg_percentile(agg_rank(10)),
+      .p50 = agg_percentile(agg_rank(50)),
+      .p90 = agg_percentile(agg_rank(90)),
+    };
+    key = k_spin_lock(&agg_lock);
+    last = *summary;
+    has_last = true;
+    agg_stats.windows++;
+    k_spin_unlock(&agg_lock, key);
+  }
+  memset(&win, 0, sizeof(win));
+  win.min = UINT8_MAX;
+  return filled;
+}
+
+int hr_agg_window_set(uint32_t ms){
+  if (ms < HR_AGG_WINDOW_MIN_MS || ms > HR_AGG_WINDOW_MAX_MS){
+    return -EINVAL;
+  }
+  window_ms = ms;
+  task_sched_set_period(TASK_SUMMARY, ms);
+  return 0;
+}
+
+uint32_t hr_agg_window_get(void){
+  return window_ms;
+}
+
+bool hr_agg_get_last(Hr_agg_summary_t *summary){
+  k_spinlock_key_t key = k_spin_lock(&agg_lock);
+  bool valid = has_last;
+  *summary = last;
+  k_spin_unlock(&agg_lock, key);
+  return valid;
+}
+
+void hr_agg_get_stats(Hr_agg_stats_t *stats){
+  k_spinlock_key_t key = k_spin_lock(&agg_lock);
+  *stats = agg_stats;
+  k_spin_unlock(&agg_lock, key);
+}
+
+void hr_agg_report(void){
+  Hr_agg_stats_t agg;
+  Hr_agg_summary_t summary;
+
+  hr_agg_get_stats(&agg);
+  LOG("HR trend: %u windows of %u s, %u samples (%u skipped), %u cycles/sample (max %u)", agg.windows,
+      hr_agg_window_get() / 1000U, agg.samples, agg.skipped, agg.samples ? agg.cycles_total / agg.samples : 0,
+      agg.cycles_max);
+  if (hr_agg_get_last(&summary)){
+    LOG("HR trend: last window %u, %u samples, min %u mean %u.%u max %u, p10 %u p50 %u p90 %u bpm", summary.seq,
+        summary.count, summary.min, summary.mean_x10 / 10U, summary.mean_x10 % 10U, summary.max, summary.p10,
+        summary.p50, summary.p90);
+  }
+}
+
+
+#if defined(CONFIG_SHELL)
+static int cmd_agg_window(const struct shell *sh, size_t argc, char **argv){
+  if (argc < 2){
+    shell_print(sh, "%u ms", hr_agg_window_get());
+    return 0;
+  }
+  if (hr_agg_window_set(strtoul(argv[1], NULL, 0)) != 0){
+    shell_error(sh, "window %u..%u ms", HR_AGG_WINDOW_MIN_MS, HR_AGG_WINDOW_MAX_MS);
+    return -EINVAL;
+  }
+  return 0;
+}
+
+static int cmd_agg_show(const struct shell *sh, size_t argc, char **argv){
+  Hr_agg_summary_t s;
+  Hr_agg_stats_t stats;
+
+  hr_agg_get_stats(&stats);
+  shell_print(sh, "%u windows, %u samples (%u skipped), %u cycles/sample (max %u)", stats.windows, stats.samples,
+              stats.skipped, stats.samples ? stats.cycles_total / stats.samples : 0, stats.cycles_max);
+  if (hr_agg_get_last(&s)){
+    shell_print(sh, "window %u (%u s): %u samples, min %u mean %u.%u max %u, p10 %u p50 %u p90 %u", s.seq,
+                s.window_s, s.count, s.min, s.mean_x10 / 10U, s.mean_x10 % 10U, s.max, s.p10, s.p50, s.p90);
+  }
+  return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_agg,
+  SHELL_CMD_ARG(window, NULL, "Get or set the window length (ms)", cmd_agg_window, 1, 1),
+  SHELL_CMD(show, NULL, "Print the last window summary", cmd_agg_show),
+  SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(agg, &sub_agg, "Heart rate aggregation", NULL);
+#endif
@@ -0,0 +1,181 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file hrv.c
+ * @brief streaming heart rate variability function definitions
+ *
+ * The window is a ring of the last RR intervals. When it is full a new interval replaces the 
+ * oldest one: Welford's update for a replaced value keeps mean and M2, the successive 
+ * difference between the two oldest intervals leaves RMSSD and pNN50 sums. The lock makes 
+ * a read consistent with the adds of the processing workqueue.
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+
+#include "hrv.h"
+#include <stdlib.h>
+
+#define HRV_Q   16    // fractional bits of mean and M2
+
+BUILD_ASSERT(HRV_WINDOW_BEATS >= 2 && HRV_WINDOW_BEATS <= UINT8_MAX, "window index is 8-bit");
+
+static struct k_spinlock hrv_lock;
+static uint16_t rr_ring[HRV_WINDOW_BEATS];
+static uint8_t rr_head;           // index of the oldest interval
+static uint16_t rr_count;
+static int64_t mean_q;            // mean RR, ms in Q16
+static int64_t m2_q;              // sum of squared deviations from the mean, ms^2 in Q16
+static uint32_t ssd;              // sum of squared successive differences, ms^2
+static uint16_t nn50;             // successive differences > HRV_NN50_MS
+static Hrv_stats_t hrv_stats;
+
+
+/***********************************************************
+ Static Function Definitions
+***********************************************************/
+static uint32_t isqrt64(uint64_t v){
+  uint64_t res = 0;
+  uint64_t bit = 1ULL << 62;
+
+  while (bit > v){
+    bit >>= 2;
+  }
+  while (bit){
+    if (v >= res + bit){
+      v -= res + bit;
+      res = (res >> 1) + bit;
+    } else {
+      res >>= 1;
+    }
+    bit >>= 2;
+  }
+  return (uint32_t)res;
+}
+
+/* Add (sign 1) or remove (sign -1) the successive difference of two intervals */
+static void diff_update(uint16_t a, uint16_t b, int32_t sign){
+  int32_t d = (int32_t)b - (int32_t)a;
+  ssd += (uint32_t)(sign * d * d);
+  if (abs(d) > HRV_NN50_MS){
+    nn50 += (uint16_t)sign;
+  }
+}
+
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+void hrv_add_rr(uint16_t rr_ms){
+  uint32_t start = k_cycle_get_32();
+  int64_t x = (int64_t)rr_ms << HRV_Q;
+  uint32_t cycles;
+  k_spinlock_key_t key = k_spin_lock(&hrv_lock);
+
+  if (rr_ms < HRV_RR_MIN_MS || rr_ms > HRV_RR_MAX_MS){
+    hrv_stats.rejected++;
+    k_spin_unlock(&hrv_lock, key);
+    return;
+  }
+  if (rr_count > 0){
+    uint16_t newest = rr_ring[(rr_head + rr_count - 1) % HRV_WINDOW_BEATS];
+    diff_update(newest, rr_ms, 1);
+  }
+  if (rr_count < HRV_WINDOW_BEATS){
+    // Welford add
+    int64_t delta = x - mean_q;
+    rr_ring[(rr_head + rr_count) % HRV_WINDOW_BEATS] = rr_ms;
+    rr_count++;
+    mean_q += delta / rr_count;
+    m2_q += (delta * (x - mean_q)) >> HRV_Q;
+  } else {
+    // Welford replace: the oldest interval leaves, its successive difference too
+    uint16_t oldest = rr_ring[rr_head];
+    int64_t x_old = (int64_t)oldest << HRV_Q;
+    int64_t mean_old = mean_q;
+    diff_update(oldest, rr_ring[(rr_head + 1) % HRV_WINDOW_BEATS], -1);
+    rr_ring[rr_head] = rr_ms;
+    rr_head = (rr_head + 1) % HRV_WINDOW_BEATS;
+    mean_q += (x - x_old) / HRV_WINDOW_BEATS;
+    m2_q += ((x - x_old) * ((x - mean_q) + (x_old - mean_old))) >> HRV_Q;
+    m2_q = MAX(m2_q, 0);
+  }
+
+  cycles = k_cycle_get_32() - start;
+  hrv_stats.beats++;
+  hrv_stats.cycles_total += cycles;
+  hrv_stats.cycles_max = MAX(hrv_stats.cycles_max, cycles);
+  k_spin_unlock(&hrv_lock, key);
+}
+
+void hrv_add_bpm(uint8_t bpm){
+  if (bpm > 0){
+    hrv_add_rr((uint16_t)((60000U + bpm / 2U) / bpm));
+  }
+}
+
+void hrv_reset(void){
+  k_spinlock_key_t key = k_spin_lock(&hrv_lock);
+  rr_head = 0;
+  rr_count = 0;
+  mean_q = 0;
+  m2_q = 0;
+  ssd = 0;
+  nn50 = 0;
+  k_spin_unlock(&hrv_lock, key);
+}
+
+bool hrv_get(Hrv_metrics_t *metrics){
+  k_spinlock_key_t key = k_spin_lock(&hrv_lock);
+  uint16_t n = rr_count;
+  int64_t mean = mean_q;
+  int64_t m2 = m2_q;
+  uint32_t sum_sq = ssd;
+  uint16_t n50 = nn50;
+  k_spin_unlock(&hrv_lock, key);
+
+  *metrics = (Hrv_metrics_t){.beats = n};
+  if (n < 2){
+    return false;
+  }
+  metrics->mean_rr_ms = (uint16_t)((mean + (1 << (HRV_Q - 1))) >> HRV_Q);
+  // sqrt(100 * M2 / (n - 1)) = SDNN in 0.1 ms
+  metrics->sdnn_x10 = (uint16_t)isqrt64(((uint64_t)m2 * 100U / (n - 1U)) >> HRV_Q);
+  metrics->rmssd_x10 = (uint16_t)isqrt64((uint64_t)sum_sq * 100U / (n - 1U));
+  metrics->pnn50_x10 = (uint16_t)((uint32_t)n50 * 1000U / (n - 1U));
+  return true;
+}
+
+void hrv_get_stats(Hrv_stats_t *stats){
+  k_spinlock_key_t key = k_spin_lock(&hrv_lock);
+  *stats = hrv_stats;
+  k_spin_unlock(&hrv_lock, key);
+}
+
+void hrv_report(void){
+  Hrv_stats_t stats;
+  Hrv_metrics_t hrv;
+
+  hrv_get_stats(&stats);
+  (void)hrv_get(&hrv);
+  LOG("HRV: %u beats (%u rejected), %u cycles/beat (max %u), window %u/%u: mean RR %u ms, SDNN %u.%u ms, "
+      "RMSSD %u.%u ms, pNN50 %u.%u %%", stats.beats, stats.rejected,
+      stats.beats ? stats.cycles_total / stats.beats : 0, stats.cycles_max, hrv.beats, HRV_WINDOW_BEATS,
+      hrv.mean_rr_ms, hrv.sdnn_x10 / 10U, hrv.sdnn_x10 % 10U, hrv.rmssd_x10 / 10U, hrv.rmssd_x10 % 10U,
+      hrv.pnn50_x10 / 10U, hrv.pnn50_x10 % 10U);
+}
@@ -0,0 +1,123 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file latency_hist.c
+ * @brief sample-to-air latency histogram function definitions
+ *
+ * The histograms can be printed with the "latency" shell command (CONFIG_SHELL) and read 
+ * over the diagnostics service (bt_diag.c).
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "latency_hist.h"
+#include <string.h>
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
+
+static Latency_hist_t lat_hist[LAT_STAGE_NUM];
+static struct k_spinlock lat_lock;  // add: bluetooth TX callbacks and proc_wq, get/reset: GATT and shell
+
+static const char *const lat_stage_name[LAT_STAGE_NUM] = {
+  [LAT_STAGE_QUEUED] = "queued",
+  [LAT_STAGE_SENT]   = "sent",
+};
+
+
+/***********************************************************
+ Static Function Definitions
+***********************************************************/
+static uint8_t latency_bucket(uint32_t ms){
+  if (ms == 0){
+    return 0;
+  }
+  return (uint8_t)MIN((uint32_t)find_msb_set(ms), LAT_BUCKETS - 1U);
+}
+
+#if defined(CONFIG_SHELL)
+static int cmd_latency_show(const struct shell *sh, size_t argc, char **argv){
+  for (uint8_t s = 0; s < LAT_STAGE_NUM; s++){
+    Latency_hist_t hist;
+    latency_hist_get((Lat_stage_t)s, &hist);
+    shell_print(sh, "%s: %u samples, mean %u ms, max %u ms", lat_stage_name[s], hist.count,
+                hist.count ? hist.sum_ms / hist.count : 0, hist.max_ms);
+    for (uint8_t b = 0; b < LAT_BUCKETS; b++){
+      if (hist.buckets[b]){
+        shell_print(sh, "  <%5u ms: %u", 1U << b, hist.buckets[b]);
+      }
+    }
+  }
+  return 0;
+}
+
+static int cmd_latency_reset(const struct shell *sh, size_t argc, char **argv){
+  latency_hist_reset();
+  shell_print(sh, "latency histograms cleared");
+  return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_latency,
+  SHELL_CMD(show, NULL, "Print sample-to-air latency histograms", cmd_latency_show),
+  SHELL_CMD(reset, NULL, "Clear latency histograms", cmd_latency_reset),
+  SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(latency, &sub_latency, "Sample-to-air latency", NULL);
+#endif
+
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+void latency_hist_add(Lat_stage_t stage, uint32_t sample_cyc, uint32_t now_cyc){
+  if (stage < LAT_STAGE_NUM){
+    Latency_hist_t *hist = &lat_hist[stage];
+    uint32_t ms = k_cyc_to_ms_floor32(now_cyc - sample_cyc);
+    uint8_t bucket = latency_bucket(ms);
+    k_spinlock_key_t key = k_spin_lock(&lat_lock);
+    hist->count++;
+    hist->sum_ms += ms;
+    hist->max_ms = MAX(hist->max_ms, ms);
+    hist->buckets[bucket]++;
+    k_spin_unlock(&lat_lock, key);
+  }
+}
+
+void latency_hist_get(Lat_stage_t stage, Latency_hist_t *hist){
+  if (stage < LAT_STAGE_NUM){
+    k_spinlock_key_t key = k_spin_lock(&lat_lock);
+    *hist = lat_hist[stage];
+    k_spin_unlock(&lat_lock, key);
+  }
+}
+
+void latency_hist_reset(void){
+  k_spinlock_key_t key = k_spin_lock(&lat_lock);
+  memset(lat_hist, 0, sizeof(lat_hist));
+  k_spin_unlock(&lat_lock, key);
+}
+
+void latency_hist_report(void){
+  for (uint8_t s = 0; s < LAT_STAGE_NUM; s++){
+    Latency_hist_t hist;
+    latency_hist_get((Lat_stage_t)s, &hist);
+    LOG("Latency %s: %u samples, mean %u ms, max %u ms", lat_stage_name[s], hist.count,
+        hist.count ? hist.sum_ms / hist.count : 0, hist.max_ms);
+  }
+}
@@ -0,0 +1,127 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file meas_rec.c
+ * @brief measurement record function definitions
+ *
+ * The latest pointer is swapped and referenced under a spinlock, so a consumer can't take 
+ * a reference to a record that the publisher is releasing.
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+
+#include "meas_rec.h"
+#include <string.h>
+
+K_MEM_SLAB_DEFINE_STATIC(meas_slab, sizeof(Meas_rec_t), MEAS_REC_COUNT, 4);
+
+static struct k_spinlock meas_lock;
+static Meas_rec_t *latest = NULL;
+static Meas_rec_stats_t meas_stats;
+
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+Meas_rec_t *meas_rec_alloc(void){
+  Meas_rec_t *rec;
+  k_spinlock_key_t key;
+
+  if (k_mem_slab_alloc(&meas_slab, (void **)&rec, K_NO_WAIT) != 0){
+    key = k_spin_lock(&meas_lock);
+    meas_stats.alloc_failures++;
+    k_spin_unlock(&meas_lock, key);
+    return NULL;
+  }
+  atomic_set(&rec->refs, 1);
+  key = k_spin_lock(&meas_lock);
+  rec->seq = meas_stats.published;
+  meas_stats.in_use++;
+  meas_stats.max_in_use = MAX(meas_stats.max_in_use, meas_stats.in_use);
+  k_spin_unlock(&meas_lock, key);
+  return rec;
+}
+
+void meas_rec_publish(Meas_rec_t *rec){
+  Meas_rec_t *prev;
+  k_spinlock_key_t key = k_spin_lock(&meas_lock);
+
+  prev = latest;
+  latest = rec;
+  meas_stats.published++;
+  k_spin_unlock(&meas_lock, key);
+  if (prev != NULL){
+    meas_rec_unref(prev);
+  }
+}
+
+Meas_rec_t *meas_rec_get_latest(void){
+  Meas_rec_t *rec;
+  k_spinlock_key_t key = k_spin_lock(&meas_lock);
+
+  rec = latest;
+  if (rec != NULL){
+    atomic_inc(&rec->refs);
+  }
+  k_spin_unlock(&meas_lock, key);
+  return rec;
+}
+
+void meas_rec_unref(Meas_rec_t *rec){
+  k_spinlock_key_t key;
+
+  // atomic_dec() returns the previous value
+  if (atomic_dec(&rec->refs) != 1){
+    return;
+  }
+  k_mem_slab_free(&meas_slab, (void **)&rec);
+  key = k_spin_lock(&meas_lock);
+  meas_stats.in_use--;
+  k_spin_unlock(&meas_lock, key);
+}
+
+int meas_rec_read(Perip_t *meas){
+  Meas_rec_t *rec = meas_rec_get_latest();
+  k_spinlock_key_t key;
+
+  if (rec == NULL){
+    return -ENODATA;
+  }
+  memcpy(meas, &rec->meas, sizeof(*meas));
+  meas_rec_unref(rec);
+  key = k_spin_lock(&meas_lock);
+  meas_stats.bytes_copied += sizeof(*meas);
+  k_spin_unlock(&meas_lock, key);
+  return 0;
+}
+
+void meas_rec_get_stats(Meas_rec_stats_t *stats){
+  k_spinlock_key_t key = k_spin_lock(&meas_lock);
+  *stats = meas_stats;
+  k_spin_unlock(&meas_lock, key);
+}
+
+void meas_rec_report(void){
+  Meas_rec_stats_t recs;
+
+  meas_rec_get_stats(&recs);
+  LOG("Meas records: %u published, %u bytes copied/measurement, %u alloc failures, max %u/%u in use",
+      recs.published, recs.published ? recs.bytes_copied / recs.published : 0, recs.alloc_failures,
+      recs.max_in_use, MEAS_REC_COUNT);
+}
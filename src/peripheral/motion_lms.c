@@ -0,0 +1,100 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file motion_lms.c
+ * @brief motion artifact canceller function definitions
+ *
+ * Weights are Q15 mV/mg. With x the reference vector and e the error, the update is 
+ * w += mu * e * x / (eps + x.x), which keeps the step independent of the motion amplitude.
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "motion_lms.h"
+#include <stdlib.h>
+
+static int32_t lms_w_q15[MOTION_LMS_TAPS];
+static int32_t hr_mean_q4;      // running mean of the heart rate signal, mV in Q4
+static bool hr_mean_valid;
+static Motion_lms_stats_t lms_stats;
+static struct k_spinlock lms_lock;
+
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+adc_sample_t motion_lms_filter(adc_sample_t sample, uint32_t ts_cyc){
+  uint32_t start = k_cycle_get_32();
+  int16_t x[MOTION_LMS_TAPS];
+  int64_t y = 0;
+  int32_t power = MOTION_LMS_EPS;
+  int32_t d;
+  int32_t e;
+  int32_t out;
+  k_spinlock_key_t key;
+
+  if (!hr_mean_valid){
+    hr_mean_q4 = (int32_t)sample << 4;
+    hr_mean_valid = true;
+  }
+  // Exponential average with weight 1/32, slow enough to keep the pulse in the error signal
+  hr_mean_q4 = ema_step(hr_mean_q4, (int32_t)sample << 4, 5);
+
+  if (!accel_fifo_ref_at(ts_cyc, x, MOTION_LMS_TAPS, k_ms_to_cyc_ceil32(MOTION_LMS_MAX_SKEW_MS))){
+    key = k_spin_lock(&lms_lock);
+    lms_stats.bypassed++;
+    k_spin_unlock(&lms_lock, key);
+    return sample;
+  }
+
+  d = (int32_t)sample - (hr_mean_q4 >> 4);
+  for (uint8_t i = 0; i < MOTION_LMS_TAPS; i++){
+    y += (int64_t)lms_w_q15[i] * x[i];
+    power += (int32_t)x[i] * x[i];
+  }
+  e = d - (int32_t)(y >> 15);
+  for (uint8_t i = 0; i < MOTION_LMS_TAPS; i++){
+    lms_w_q15[i] += (int32_t)(((int64_t)MOTION_LMS_MU_Q15 * e * x[i]) / power);
+  }
+
+  out = (hr_mean_q4 >> 4) + e;
+  key = k_spin_lock(&lms_lock);
+  // Exponential average with weight 1/8 of the removed artifact
+  lms_stats.removed_q4 = (uint16_t)ema_step(lms_stats.removed_q4, (int32_t)MIN(abs(d - e), 4095) << 4, 3);
+  lms_stats.samples++;
+  lms_stats.cycles_total += k_cycle_get_32() - start;
+  k_spin_unlock(&lms_lock, key);
+  return adc_sample_sat(out);
+}
+
+void motion_lms_get_stats(Motion_lms_stats_t *stats){
+  k_spinlock_key_t key = k_spin_lock(&lms_lock);
+  *stats = lms_stats;
+  k_spin_unlock(&lms_lock, key);
+}
+
+void motion_lms_report(void){
+  Motion_lms_stats_t lms;
+
+  if (!accel_fifo_ready()){
+    return;
+  }
+  motion_lms_get_stats(&lms);
+  LOG("Motion LMS: %u filtered, %u bypassed, %u cycles/sample, artifact %u.%02u mV", lms.samples, lms.bypassed,
+      lms.samples ? lms.cycles_total / lms.samples : 0, lms.removed_q4 >> 4, ((lms.removed_q4 & 0xF) * 100) >> 4);
+}
@@ -21,86 +21,220 @@
 #include "peripheral.h"
 
 
-extern Gpio_t gpio_a[NUM_GPIO_PERIP]; // array of gpio peripheral
-extern Adc_t adc_a[ADC_NUM_CHANNELS]; // array of gpio peripheral
-Perip_t perip = {.adc_batt_mV = 0.0F, .bt_batt_lvl = 0U, .adc_heart_rate_mV = 0.0F,  .bt_heart_rate = 0U};
+static uint32_t suppressed_hrs; // notifications skipped for low signal quality
+static uint32_t suppressed_bas;
 
 
 /***********************************************************
  Function Definitions
 ***********************************************************/
 void peripheral_init() {
-  int err;
+  // Start the network core first, gpio and adc setup overlaps the controller boot
+  if (bt_init_async()) {
+    LOG("Bluetooth init request failed\n");
+  }
 
   //Button 1 to start reading measurements
-  gpio_enable(gpio_a, BTN1_ch, true);
-  gpio_enable_interrupt(gpio_a, BTN1_ch, true);
-  gpio_init(gpio_a, BTN1_ch, NUM_GPIO_PERIP);
-  gpio_configure(gpio_a, BTN1_ch, NUM_GPIO_PERIP);
-  gpio_configure_interrupt(gpio_a, BTN1_ch, NUM_GPIO_PERIP); 
+  gpio_enable(BTN1_ch, true);
+  gpio_enable_interrupt(BTN1_ch, true);
+  gpio_init(BTN1_ch);
+  gpio_configure(BTN1_ch);
+  gpio_configure_interrupt(BTN1_ch); 
 
   //Button 2 to stop reading measurements
-  gpio_enable(gpio_a, BTN2_ch, true);
-  gpio_enable_interrupt(gpio_a, BTN2_ch, true);
-  gpio_init(gpio_a, BTN2_ch, NUM_GPIO_PERIP);
-  gpio_configure(gpio_a, BTN2_ch, NUM_GPIO_PERIP);
-  gpio_configure_interrupt(gpio_a, BTN2_ch, NUM_GPIO_PERIP); 
+  gpio_enable(BTN2_ch, true);
+  gpio_enable_interrupt(BTN2_ch, true);
+  gpio_init(BTN2_ch);
+  gpio_configure(BTN2_ch);
+  gpio_configure_interrupt(BTN2_ch); 
 
   adc_init();  
-
-	err = bt_enable(NULL);
-	if (err) {
-		LOG("Bluetooth init failed (err %d)\n", err);
-		return;
-	}
-
-	bt_ready();
-	bt_conn_auth_cb_reg();
+#if defined(CONFIG_ADC_EMUL)
+  adc_replay_init();
+#endif
+  // Motion artifact canceller on the heart rate channel, only with an accelerometer
+  if (accel_fifo_init() == 0){
+    adc_filter_set(HR_CH, motion_lms_filter);
+  }
+  boot_time_mark(BOOT_EVT_PERIPH_READY);
 
   LOG("Peripherals initialized successfully.\n");
 }
 
 
+static void log_button_event(uint8_t channel){
+  Gpio_isr_stats_t stats;
+  get_gpio_isr_stats(&stats);
+  LOG("GPIO interrupt triggered for %s", get_gpio_label(channel));
+  LOG("GPIO ISR: %u calls, %u pins, max %u us, avg %u us", stats.count, stats.pins,
+      k_cyc_to_us_floor32(stats.max_cycles), 
+      stats.count ? k_cyc_to_us_floor32(stats.total_cycles / stats.count) : 0);
+}
+
 bool is_button1_pressed(){
-  bool status = get_gpio_interrupt_status(gpio_a, BTN1_ch);
+  bool status = take_gpio_interrupt(BTN1_ch);
   if (status){
-    reset_gpio_interrupt(gpio_a, BTN1_ch);
+    log_button_event(BTN1_ch);
   }
 	return status; 
 }
 
 bool is_button2_pressed(){
-  bool status = get_gpio_interrupt_status(gpio_a, BTN2_ch);
+  bool status = take_gpio_interrupt(BTN2_ch);
   if (status){
-    reset_gpio_interrupt(gpio_a, BTN2_ch);
+    log_button_event(BTN2_ch);
   }
 	return status; 
 }
 
-void bt_bas_set(void){
-  LOG("Battery adc voltage: %.1f mV.", perip.adc_batt_mV);
-	bt_bas_set_battery_level(perip.bt_batt_lvl);
-  LOG("Battery level: %d %%.", perip.bt_batt_lvl);
+/* Latest measurement: a reference to the record, or a private copy in the baseline build */
+static const Perip_t *meas_take(Meas_rec_t **rec, Perip_t *copy){
+#if MEAS_REC_ZERO_COPY
+  *rec = meas_rec_get_latest();
+  return (*rec != NULL) ? &(*rec)->meas : NULL;
+#else
+  *rec = NULL;
+  return (meas_rec_read(copy) == 0) ? copy : NULL;
+#endif
+}
+
+static void meas_release(Meas_rec_t *rec){
+  if (rec != NULL){
+    meas_rec_unref(rec);
+  }
+}
+
+static bool bas_stage(const Perip_t *meas){
+  LOG("Battery adc voltage: %.1f mV.", meas->adc_batt_mV);
+  // Don't spend airtime on a value computed from an unusable signal
+  if (!adc_signal_usable(BATT_CH)){
+    suppressed_bas++;
+    LOG("Battery level not sent, signal quality too low (%u suppressed).", suppressed_bas);
+    return false;
+  }
+  LOG("Battery level: %d %%.", meas->bt_batt_lvl);
+  return bt_notify_stage_bas(meas->bt_batt_lvl) == 0;
+}
+
+static bool hrs_stage(const Perip_t *meas){
+    LOG("Heartrate adc voltage: %.1f mV.",meas->adc_heart_rate_mV);
+    if (!adc_signal_usable(HR_CH)){
+      suppressed_hrs++;
+      LOG("Heartrate not sent, signal quality too low (%u suppressed).", suppressed_hrs);
+      return false;
+    }
+    LOG("Heartrate: %d bpm.",meas->bt_heart_rate);
+    return bt_notify_stage_hrs(meas->bt_heart_rate, meas->hr_sample_cyc) == 0;
+}
+
+bool bt_bas_stage(void){
+  Meas_rec_t *rec;
+  Perip_t copy;
+  const Perip_t *meas = meas_take(&rec, &copy);
+  bool staged = (meas != NULL) && bas_stage(meas);
+  meas_release(rec);
+  return staged;
 }
 
-void bt_hrs_set(void){
-    LOG("Heartrate adc voltage: %.1f mV.",perip.adc_heart_rate_mV);
-  	bt_hrs_notify(perip.bt_heart_rate);
-    LOG("Heartrate: %d bpm.",perip.bt_heart_rate);
+bool bt_hrs_stage(void){
+  Meas_rec_t *rec;
+  Perip_t copy;
+  const Perip_t *meas = meas_take(&rec, &copy);
+  bool staged = (meas != NULL) && hrs_stage(meas);
+  meas_release(rec);
+  return staged;
 }
 
+bool bt_summary_stage(void){
+  Hr_agg_summary_t summary;
+#if defined(CONFIG_APP_HRV)
+  Hrv_metrics_t hrv;
+  if (hrv_get(&hrv)){
+    (void)bt_trend_stage_hrv(&hrv);
+  }
+#endif
+  return hr_agg_close(&summary) && bt_trend_stage_summary(&summary) == 0;
+}
+
+void bt_staged_flush(void){
+  (void)bt_notify_flush();
+}
+
+
+void perip_acquire(uint8_t channel){
+  (void)adc_sample_ch(channel);
+}
+
+uint32_t perip_process(void){
+  return adc_process_samples();
+}
+
+void perip_motion_start(struct k_work_q *queue){
+  accel_fifo_start(queue);
+}
 
-void set_heart_rate_value(void){
-  uint16_t hr_voltage_mv = adc_read_ch_data(HR_CH, ADC_NUM_CHANNELS);
-  perip.adc_heart_rate_mV = (float)hr_voltage_mv;
-  perip.bt_heart_rate = (uint8_t)(perip.adc_heart_rate_mV * (HR_MAX_VALUE - HR_MIN_VALUE) / VDD  + HR_MIN_VALUE);
-  
+void perip_measure(uint8_t due_mask){
+  Meas_rec_t *rec = meas_rec_alloc();
+  if (rec == NULL){
+    return;
+  }
+  // Channels not sampled in this round keep their average, the record is always complete
+  set_heart_rate_value(&rec->meas);
+  set_battery_perc(&rec->meas);
+  if (due_mask & BIT(HR_CH)){
+    boot_time_mark(BOOT_EVT_FIRST_SAMPLE);
+    if (adc_signal_usable(HR_CH)){
+      // The value stands until the next sample: the period set by this round
+      hr_agg_add(rec->meas.bt_heart_rate, adc_get_period_ms(HR_CH));
+#if defined(CONFIG_APP_HRV)
+      hrv_add_bpm(rec->meas.bt_heart_rate);
+#endif
+    } else {
+      hr_agg_skip();
+    }
+  }
+  meas_rec_publish(rec);
 }
 
-void set_battery_perc(void){
-  uint16_t batt_voltage_mv = adc_read_ch_data(BATT_CH, ADC_NUM_CHANNELS);
-  perip.adc_batt_mV = (float)batt_voltage_mv;
-  perip.bt_batt_lvl = (uint8_t)(perip.adc_batt_mV * (BATT_MAX_PERC_VALUE - BATT_MIN_PERC_VALUE) / VDD  + BATT_MIN_PERC_VALUE);
+void set_heart_rate_value(Perip_t *meas){
+  uint16_t hr_voltage_mv = adc_get_media(HR_CH);
+  meas->adc_heart_rate_mV = (float)hr_voltage_mv;
+  meas->bt_heart_rate = (uint8_t)(meas->adc_heart_rate_mV * (HR_MAX_VALUE - HR_MIN_VALUE) / VDD  + HR_MIN_VALUE);
+  meas->hr_sample_cyc = adc_get_sample_cyc(HR_CH);
 }
 
+void set_battery_perc(Perip_t *meas){
+  uint16_t batt_voltage_mv = adc_get_media(BATT_CH);
+  meas->adc_batt_mV = (float)batt_voltage_mv;
+  meas->bt_batt_lvl = (uint8_t)(meas->adc_batt_mV * (BATT_MAX_PERC_VALUE - BATT_MIN_PERC_VALUE) / VDD  + BATT_MIN_PERC_VALUE);
+}
 
+void perip_report(void){
+  Adc_perf_t hr_perf;
+  Adc_perf_t batt_perf;
+  Gpio_isr_stats_t isr;
+  Bt_notify_stats_t ntf;
+  Bt_sync_stats_t sync;
+  Meas_rec_t *rec;
+  Perip_t copy;
+
+  // Cost per call, parsed by bench/bsim/bench_report.py to compare two builds
+  adc_get_perf(HR_CH, &hr_perf);
+  adc_get_perf(BATT_CH, &batt_perf);
+  get_gpio_isr_stats(&isr);
+  bt_notify_get_stats(&ntf);
+  bt_sync_get_stats(&sync);
+  LOG("COST {\"adc_hr_cycles\": %u, \"adc_batt_cycles\": %u, \"gpio_isr_cycles\": %u, "
+      "\"notify_cycles\": %u, \"notify_copy_bytes\": %u, \"radio_overlap_permille\": %u}",
+      adc_get_conversions(HR_CH) ? hr_perf.cycles_total / adc_get_conversions(HR_CH) : 0,
+      adc_get_conversions(BATT_CH) ? batt_perf.cycles_total / adc_get_conversions(BATT_CH) : 0,
+      isr.count ? isr.total_cycles / isr.count : 0, ntf.values ? ntf.cycles_total / ntf.values : 0,
+      ntf.values ? ntf.bytes_copied / ntf.values : 0,
+      sync.busy_us ? (uint32_t)(sync.overlap_us * 1000U / sync.busy_us) : 0);
+  const Perip_t *meas = meas_take(&rec, &copy);
+  if (meas != NULL){
+    LOG("Last measurement: %u bpm (%.1f mV), battery %u %% (%.1f mV)", meas->bt_heart_rate,
+        meas->adc_heart_rate_mV, meas->bt_batt_lvl, meas->adc_batt_mV);
+  }
+  meas_release(rec);
+}
@@ -0,0 +1,169 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file proc_wq.c
+ * @brief processing workqueue function definitions
+ *
+ * This implementation file runs the acquisition stage (adc conversions of the due channels)
+ * and the DSP stage (conversion to heart rate / battery level) as work items with deadlines.
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "proc_wq.h"
+#include "peripheral.h"
+
+static K_THREAD_STACK_DEFINE(proc_wq_stack, CONFIG_APP_PROC_WQ_STACK_SIZE);
+static struct k_work_q proc_wq;
+
+static void dsp_handler(struct k_work *work);
+
+static K_WORK_DEFINE(dsp_work, dsp_handler);
+
+static uint32_t release_cyc;    // expected start of the current round
+static uint32_t deadline_cyc;   // relative deadline of the current round
+static uint8_t due_mask;        // channels sampled in the current round
+static Proc_stats_t proc_stats;
+
+
+/***********************************************************
+ Static Function Definitions
+***********************************************************/
+static void schedule_round(void){
+  uint32_t delay_ms = adc_next_due_ms(k_uptime_get_32());
+  release_cyc = k_cycle_get_32() + k_ms_to_cyc_ceil32(delay_ms);
+  task_sched_run_in(TASK_SAMPLE, delay_ms);
+}
+
+/* Acquisition stage, sampling task of the scheduler */
+static void sample_task(void){
+  uint32_t now = k_uptime_get_32();
+  uint32_t period_ms = UINT32_MAX;
+
+  due_mask = 0;
+  for (uint8_t ch = 0; ch < ADC_NUM_CHANNELS; ch++){
+    if (adc_channel_is_due(ch, now)){
+      due_mask |= BIT(ch);
+      period_ms = MIN(period_ms, adc_get_period_ms(ch));
+    }
+  }
+  if (due_mask == 0){
+    schedule_round();
+    return;
+  }
+
+  // The round must be processed before the next sample of its fastest channel
+  deadline_cyc = k_ms_to_cyc_ceil32(period_ms);
+#if PROC_WQ_USE_DEADLINE
+  k_thread_deadline_set(k_current_get(), (int)deadline_cyc);
+#endif
+
+  for (uint8_t ch = 0; ch < ADC_NUM_CHANNELS; ch++){
+    if (due_mask & BIT(ch)){
+      perip_acquire(ch);
+    }
+  }
+  k_work_submit_to_queue(&proc_wq, &dsp_work);
+}
+
+static void dsp_handler(struct k_work *work){
+  uint32_t start = k_cycle_get_32();
+  uint32_t elapsed;
+
+  (void)perip_process();
+  perip_measure(due_mask);
+  bt_sync_cpu_busy(k_cycle_get_32() - start);
+
+  elapsed = k_cycle_get_32() - release_cyc;
+  proc_stats.rounds++;
+  if (elapsed > deadline_cyc){
+    proc_stats.misses++;
+  }
+  proc_stats.max_latency_us = MAX(proc_stats.max_latency_us, k_cyc_to_us_floor32(elapsed));
+
+  schedule_round();
+}
+
+/* Tick hook of the scheduler: send the staged values, then account the wakeup */
+static void proc_tick(void){
+  bt_staged_flush();
+  bt_sync_cpu_busy(k_cycle_get_32() - task_sched_wakeup_cyc());
+}
+
+#if defined(CONFIG_APP_PROC_LOAD_TEST)
+/* Benchmark load: console, cpu and bluetooth. The notifications are staged and flushed through 
+ * the grouped path, so the load thread contends with proc_wq for the notify lock and the buffers */
+static void load_thread(void){
+  while(1){
+    uint32_t start = k_uptime_get_32();
+    LOG("load: console flood to stress the processing deadlines");
+    k_busy_wait(PROC_LOAD_BUSY_MS * 1000);
+    (void)bt_hrs_stage();
+    (void)bt_bas_stage();
+    bt_staged_flush();
+#if PROC_WQ_USE_DEADLINE
+    k_thread_deadline_set(k_current_get(), (int)k_ms_to_cyc_ceil32(PROC_LOAD_PERIOD_MS));
+#endif
+    k_sleep(K_MSEC(PROC_LOAD_PERIOD_MS - MIN(k_uptime_get_32() - start, PROC_LOAD_PERIOD_MS)));
+  }
+}
+
+K_THREAD_DEFINE(load_thread_id, PROC_LOAD_STACK_SIZE, load_thread, NULL, NULL, NULL, PROC_WQ_PRIORITY, 0, 0);
+#endif
+
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+void proc_wq_start(void){
+  const struct k_work_queue_config cfg = {
+    .name = "proc_wq",
+    .no_yield = false,
+  };
+  k_work_queue_start(&proc_wq, proc_wq_stack, K_THREAD_STACK_SIZEOF(proc_wq_stack), PROC_WQ_PRIORITY, &cfg);
+  // Values staged by the tasks of a wakeup are sent in one flush
+  task_sched_start(&proc_wq, proc_tick);
+  task_sched_add(TASK_SAMPLE, "sample", sample_task, 0, 0, 0);
+  task_sched_add(TASK_CONFIG, "config", app_cfg_apply, 0, 0, 0);
+  perip_motion_start(&proc_wq);
+  schedule_round();
+}
+
+void proc_wq_sample_now(uint8_t mask){
+  due_mask &= ~mask;
+  for (uint8_t ch = 0; ch < ADC_NUM_CHANNELS; ch++){
+    if (mask & BIT(ch)){
+      perip_acquire(ch);
+    }
+  }
+  (void)perip_process();
+  perip_measure(mask);
+}
+
+void proc_wq_get_stats(Proc_stats_t *stats){
+  *stats = proc_stats;
+}
+
+void proc_wq_report(void){
+  Proc_stats_t stats;
+  proc_wq_get_stats(&stats);
+  LOG("Processing: %u rounds, %u deadline misses (%u.%02u %%), max latency %u us", stats.rounds, stats.misses,
+      stats.rounds ? (uint32_t)(((uint64_t)stats.misses * 100U) / stats.rounds) : 0,
+      stats.rounds ? (uint32_t)((((uint64_t)stats.misses * 10000U) / stats.rounds) % 100) : 0, stats.max_latency_us);
+  task_sched_report();
+}
@@ -0,0 +1,65 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file spsc_ring.c
+ * @brief single producer / single consumer ring function definitions
+ *
+ * Head and tail are free running counters, the slot index is the counter masked
+ * with the capacity. Zephyr atomic_get()/atomic_set() are sequentially consistent,
+ * which orders the slot access against the index update on both sides.
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+#include "spsc_ring.h"
+
+#define SPSC_RING_MASK (SPSC_RING_CAPACITY - 1U)
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+bool spsc_ring_push(Spsc_ring_t *ring, const Adc_raw_sample_t *sample){
+  uint32_t head = (uint32_t)atomic_get(&ring->head);
+  uint32_t tail = (uint32_t)atomic_get(&ring->tail);
+
+  if ((head - tail) >= SPSC_RING_CAPACITY){
+    ring->overruns++;
+    return false;
+  }
+  ring->slots[head & SPSC_RING_MASK] = *sample;
+  // Publish the slot only after it is completely written
+  atomic_set(&ring->head, (atomic_val_t)(head + 1U));
+  return true;
+}
+
+uint32_t spsc_ring_pop_batch(Spsc_ring_t *ring, Adc_raw_sample_t *out, uint32_t max){
+  uint32_t tail = (uint32_t)atomic_get(&ring->tail);
+  uint32_t head = (uint32_t)atomic_get(&ring->head);
+  uint32_t n = MIN(head - tail, max);
+
+  for (uint32_t i = 0; i < n; i++){
+    out[i] = ring->slots[(tail + i) & SPSC_RING_MASK];
+  }
+  // Release the slots only after they are copied
+  atomic_set(&ring->tail, (atomic_val_t)(tail + n));
+  return n;
+}
+
+uint32_t spsc_ring_count(Spsc_ring_t *ring){
+  return (uint32_t)atomic_get(&ring->head) - (uint32_t)atomic_get(&ring->tail);
+}
@@ -0,0 +1,230 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file task_sched.c
+ * @brief application task scheduler function definitions
+ *
+ * The task table is shared with main() (task_sched_add()) and the ISR (task_sched_post() uses
+ * an atomic bitmask), task functions run outside of the lock.
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+
+#include "task_sched.h"
+
+typedef struct
+{
+  const char   *name;
+  Task_fn_t     fn;
+  uint32_t      period_ms;
+  uint32_t      phase_ms;
+  uint32_t      slack_ms;
+  uint32_t      due_ms;
+  bool          armed;
+  Task_stats_t  stats;
+}Task_t;
+
+static void sched_handler(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(sched_work, sched_handler);
+static struct k_spinlock sched_lock;
+static struct k_work_q *sched_queue;
+static Task_fn_t sched_hook;
+static uint32_t start_ms;
+static uint32_t wakeups;
+static uint32_t wakeup_cyc;
+static atomic_t posted = ATOMIC_INIT(0);
+static Task_t tasks[TASK_NUM];
+
+
+/***********************************************************
+ Static Function Definitions
+***********************************************************/
+static void sched_rearm(void){
+  uint32_t now = k_uptime_get_32();
+  uint32_t delay_ms = UINT32_MAX;
+  k_spinlock_key_t key = k_spin_lock(&sched_lock);
+
+  for (uint8_t i = 0; i < TASK_NUM; i++){
+    if (tasks[i].armed){
+      int32_t left = (int32_t)(tasks[i].due_ms - now);
+      delay_ms = MIN(delay_ms, (uint32_t)MAX(left, 0));
+    }
+  }
+  k_spin_unlock(&sched_lock, key);
+
+  if (delay_ms != UINT32_MAX){
+    k_work_reschedule_for_queue(sched_queue, &sched_work, K_MSEC(delay_ms));
+  }
+  // A post between the scan and the reschedule must not be delayed
+  if (atomic_get(&posted)){
+    k_work_reschedule_for_queue(sched_queue, &sched_work, K_NO_WAIT);
+  }
+}
+
+/* Take the task if it is due, periodic tasks move to their next due time */
+/* First due time after now on the grid of the scheduler start, so aligned periods stay aligned */
+static uint32_t task_first_due(const Task_t *t, uint32_t now){
+  uint32_t elapsed = now - start_ms;
+  uint32_t k = (elapsed > t->phase_ms) ? (elapsed - t->phase_ms + t->period_ms - 1U) / t->period_ms : 0;
+  return start_ms + t->phase_ms + k * t->period_ms;
+}
+
+static bool task_take(Task_t *t, uint32_t now, bool is_posted){
+  bool due;
+  k_spinlock_key_t key = k_spin_lock(&sched_lock);
+
+  due = t->armed && (int32_t)(t->due_ms - now) <= (int32_t)t->slack_ms;
+  if (due){
+    int32_t late = (int32_t)(now - t->due_ms);
+    if (late > 0){
+      t->stats.max_late_ms = MAX(t->stats.max_late_ms, (uint32_t)late);
+      if (t->period_ms && (uint32_t)late >= t->period_ms){
+        // Skip the missed periods
+        t->stats.overruns++;
+        t->due_ms += ((uint32_t)late / t->period_ms) * t->period_ms;
+      }
+    }
+    if (t->period_ms){
+      t->due_ms += t->period_ms;
+    } else {
+      t->armed = false;
+    }
+  }
+  k_spin_unlock(&sched_lock, key);
+  return (due || is_posted) && t->fn != NULL;
+}
+
+static void sched_handler(struct k_work *work){
+  uint32_t now = k_uptime_get_32();
+  uint32_t post_mask = (uint32_t)atomic_clear(&posted);
+  uint8_t ran = 0;
+
+  wakeup_cyc = k_cycle_get_32();
+  wakeups++;
+  for (uint8_t i = 0; i < TASK_NUM; i++){
+    Task_t *t = &tasks[i];
+    uint32_t start;
+    uint32_t cycles;
+
+    if (!task_take(t, now, (post_mask & BIT(i)) != 0)){
+      continue;
+    }
+    start = k_cycle_get_32();
+    t->fn();
+    cycles = k_cycle_get_32() - start;
+    t->stats.runs++;
+    t->stats.coalesced += ran ? 1U : 0U;
+    t->stats.cycles_total += cycles;
+    t->stats.cycles_max = MAX(t->stats.cycles_max, cycles);
+    ran++;
+  }
+  if (ran && sched_hook != NULL){
+    sched_hook();
+  }
+  sched_rearm();
+}
+
+
+/***********************************************************
+ Function Definitions
+***********************************************************/
+void task_sched_start(struct k_work_q *queue, Task_fn_t tick_hook){
+  sched_queue = queue;
+  sched_hook = tick_hook;
+  start_ms = k_uptime_get_32();
+}
+
+void task_sched_add(Task_id_t id, const char *name, Task_fn_t fn, uint32_t period_ms, uint32_t phase_ms,
+                    uint32_t slack_ms){
+  uint32_t now = k_uptime_get_32();
+  Task_t *t = &tasks[id];
+  k_spinlock_key_t key = k_spin_lock(&sched_lock);
+
+  t->name = name;
+  t->fn = fn;
+  t->period_ms = period_ms;
+  t->phase_ms = phase_ms;
+  t->slack_ms = slack_ms;
+  t->armed = (period_ms != 0);
+  if (t->armed){
+    t->due_ms = task_first_due(t, now);
+  }
+  k_spin_unlock(&sched_lock, key);
+  sched_rearm();
+}
+
+void task_sched_run_in(Task_id_t id, uint32_t delay_ms){
+  k_spinlock_key_t key = k_spin_lock(&sched_lock);
+  tasks[id].due_ms = k_uptime_get_32() + delay_ms;
+  tasks[id].armed = true;
+  k_spin_unlock(&sched_lock, key);
+  sched_rearm();
+}
+
+void task_sched_post(Task_id_t id){
+  atomic_set_bit(&posted, id);
+  // Before the start the bit waits for the first wakeup
+  if (sched_queue != NULL){
+    k_work_reschedule_for_queue(sched_queue, &sched_work, K_NO_WAIT);
+  }
+}
+
+void task_sched_set_period(Task_id_t id, uint32_t period_ms){
+  Task_t *t = &tasks[id];
+  k_spinlock_key_t key = k_spin_lock(&sched_lock);
+
+  if (t->fn == NULL || !t->armed || period_ms == 0 || t->period_ms == period_ms){
+    k_spin_unlock(&sched_lock, key);
+    return;
+  }
+  t->period_ms = period_ms;
+  t->due_ms = task_first_due(t, k_uptime_get_32());
+  k_spin_unlock(&sched_lock, key);
+  if (sched_queue != NULL){
+    sched_rearm();
+  }
+}
+
+uint32_t task_sched_wakeup_cyc(void){
+  return wakeup_cyc;
+}
+
+void task_sched_get_stats(Task_id_t id, Task_stats_t *stats){
+  k_spinlock_key_t key = k_spin_lock(&sched_lock);
+  *stats = tasks[id].stats;
+  k_spin_unlock(&sched_lock, key);
+}
+
+void task_sched_report(void){
+  uint32_t elapsed_ms = k_uptime_get_32() - start_ms;
+
+  LOG("Scheduler: %u wakeups, %u per minute", wakeups,
+      elapsed_ms ? (uint32_t)((uint64_t)wakeups * 60000U / elapsed_ms) : 0);
+  for (uint8_t i = 0; i < TASK_NUM; i++){
+    Task_stats_t stats;
+    if (tasks[i].fn == NULL){
+      continue;
+    }
+    task_sched_get_stats((Task_id_t)i, &stats);
+    LOG("Task %s: %u runs, %u coalesced, %u overruns, max late %u ms, %u cycles/run (max %u)", tasks[i].name,
+        stats.runs, stats.coalesced, stats.overruns, stats.max_late_ms,
+        stats.runs ? stats.cycles_total / stats.runs : 0, stats.cycles_max);
+  }
+}
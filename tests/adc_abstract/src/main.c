@@ -0,0 +1,136 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file main.c
+ * @brief average window of adc_abstract with 16-bit sample storage
+ *
+ * The FIFO used to store int32_t samples and sum them in 16 bits. The reference below keeps 
+ * that arithmetic: for every window length and any in-range millivolt stream, the average 
+ * of the 16-bit saturated storage must be the same value. Out of range readings are the 
+ * only difference: they saturate instead of wrapping.
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+
+#include <zephyr/ztest.h>
+#include <string.h>
+#include "adc_abstract.h"
+
+#define TEST_SAMPLES  2000
+#define TEST_MAX_MV   3600    // full scale of the 12-bit conversions, internal reference
+
+/* FIFO before the 16-bit storage */
+typedef struct
+{
+  int32_t   data_set[BUFFER_SIZE];
+  uint16_t  count;
+  uint8_t   length;
+}Ref_fifo_t;
+
+static Ref_fifo_t ref;
+static uint32_t lcg_state;
+
+
+/***********************************************************
+ Static Function Definitions
+***********************************************************/
+static uint32_t lcg_next(void){
+  lcg_state = lcg_state * 1664525U + 1013904223U;
+  return lcg_state >> 8;
+}
+
+static void ref_add(int32_t mv){
+  if (ref.count < ref.length){
+    ref.data_set[ref.count++] = mv;
+  } else {
+    for (uint8_t i = 0; i < ref.length - 1; i++){
+      ref.data_set[i] = ref.data_set[i + 1];
+    }
+    ref.data_set[ref.length - 1] = mv;
+  }
+}
+
+static uint16_t ref_media(void){
+  uint16_t sum = 0;
+
+  if (ref.count == 0){
+    return 0;
+  }
+  for (uint8_t i = 0; i < ref.count; i++){
+    sum += (uint16_t)ref.data_set[i];
+  }
+  return sum / ref.count;
+}
+
+/* Shrinking the window keeps the newest samples, on both sides */
+static void window_set(uint8_t length){
+  Adc_tune_t tune;
+
+  adc_tune_get(HR_CH, &tune);
+  tune.filter_len = length;
+  zassert_equal(adc_tune_set(HR_CH, &tune), 0, "window %u refused", length);
+  if (ref.count > length){
+    memmove(ref.data_set, &ref.data_set[ref.count - length], length * sizeof(ref.data_set[0]));
+    ref.count = length;
+  }
+  ref.length = length;
+}
+
+/* Same starting point for every test: a window of one zero sample */
+static void adc_before(void *fixture){
+  ARG_UNUSED(fixture);
+  window_set(1);
+  Ff_buffer_add(HR_CH, 0);
+  ref.count = 0;
+  ref_add(0);
+}
+
+
+/***********************************************************
+ Tests
+***********************************************************/
+ZTEST(adc_abstract, test_storage_size){
+  zassert_equal(sizeof(adc_sample_t), 2, "sample stored on %u bytes", (unsigned int)sizeof(adc_sample_t));
+}
+
+ZTEST(adc_abstract, test_average_identical){
+  lcg_state = 2025U;
+  for (uint8_t length = 1; length <= BUFFER_SIZE; length++){
+    window_set(length);
+    for (uint16_t i = 0; i < TEST_SAMPLES; i++){
+      // Full range noise, then a slow ramp with small noise, as a heart rate signal
+      int32_t mv = (i < TEST_SAMPLES / 2) ? (int32_t)(lcg_next() % (TEST_MAX_MV + 1U)) :
+                   (int32_t)((i * 3U) % TEST_MAX_MV + lcg_next() % 8U);
+
+      Ff_buffer_add(HR_CH, mv);
+      ref_add(mv);
+      zassert_equal(adc_get_media(HR_CH), ref_media(), "window %u, sample %u: %u != %u", length, i,
+                    adc_get_media(HR_CH), ref_media());
+    }
+  }
+}
+
+ZTEST(adc_abstract, test_out_of_range_saturates){
+  Ff_buffer_add(HR_CH, -25);
+  zassert_equal(adc_get_media(HR_CH), 0, "negative reading %u", adc_get_media(HR_CH));
+  Ff_buffer_add(HR_CH, 70000);
+  zassert_equal(adc_get_media(HR_CH), ADC_SAMPLE_MAX, "reading above 16 bits %u", adc_get_media(HR_CH));
+}
+
+ZTEST_SUITE(adc_abstract, NULL, NULL, adc_before, NULL, NULL);
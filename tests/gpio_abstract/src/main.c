@@ -0,0 +1,140 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file main.c
+ * @brief gpio interrupt dispatch on the GPIO emulator
+ *
+ * The buttons of boards/native_posix.overlay are driven with gpio_emul_input_set(): an edge 
+ * to the active level must post the event of its channel only, through the lookup table 
+ * generated from devicetree. A disabled interrupt must not post, and enabling it again must 
+ * turn the pin back on in hardware.
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+
+#include <zephyr/ztest.h>
+#include <zephyr/drivers/gpio/gpio_emul.h>
+#include "gpio_abstract.h"
+
+static const struct gpio_dt_spec btn[NUM_GPIO_PERIP] = {
+  [BTN1_ch] = GPIO_DT_SPEC_GET(BTN1_NODE, gpios),
+  [BTN2_ch] = GPIO_DT_SPEC_GET(BTN2_NODE, gpios),
+};
+
+static volatile uint32_t handler_calls;
+
+
+/***********************************************************
+ Static Function Definitions
+***********************************************************/
+static void btn_set(uint8_t ch, bool pressed){
+  bool active_low = (btn[ch].dt_flags & GPIO_ACTIVE_LOW) != 0;
+  (void)gpio_emul_input_set(btn[ch].port, btn[ch].pin, pressed != active_low);
+}
+
+static void btn_click(uint8_t ch){
+  btn_set(ch, true);
+  btn_set(ch, false);
+}
+
+static void event_handler(void){
+  handler_calls++;
+}
+
+static void *gpio_setup(void){
+  for (uint8_t ch = 0; ch < NUM_GPIO_PERIP; ch++){
+    gpio_enable(ch, true);
+    gpio_enable_interrupt(ch, true);
+    gpio_init(ch);
+    gpio_configure(ch);
+    btn_set(ch, false);
+    gpio_configure_interrupt(ch);
+  }
+  gpio_set_event_handler(event_handler);
+  return NULL;
+}
+
+static void gpio_before(void *fixture){
+  ARG_UNUSED(fixture);
+  for (uint8_t ch = 0; ch < NUM_GPIO_PERIP; ch++){
+    gpio_enable_interrupt(ch, true);
+    btn_set(ch, false);
+    reset_gpio_interrupt(ch);
+  }
+  handler_calls = 0;
+}
+
+
+/***********************************************************
+ Tests
+***********************************************************/
+ZTEST(gpio_abstract, test_dispatch)
+{
+  for (uint8_t ch = 0; ch < NUM_GPIO_PERIP; ch++){
+    btn_click(ch);
+    for (uint8_t other = 0; other < NUM_GPIO_PERIP; other++){
+      zassert_equal(take_gpio_interrupt(other), other == ch, "ch%u: event of ch%u", ch, other);
+    }
+  }
+  zassert_equal(handler_calls, NUM_GPIO_PERIP, "one handler call per click, got %u", handler_calls);
+}
+
+ZTEST(gpio_abstract, test_release_edge)
+{
+  btn_set(BTN1_ch, true);
+  zassert_true(take_gpio_interrupt(BTN1_ch), "press not posted");
+  btn_set(BTN1_ch, false);
+  zassert_false(take_gpio_interrupt(BTN1_ch), "release posted");
+}
+
+ZTEST(gpio_abstract, test_disable_enable)
+{
+  gpio_enable_interrupt(BTN1_ch, false);
+  btn_click(BTN1_ch);
+  zassert_false(get_gpio_interrupt_status(BTN1_ch), "disabled interrupt posted");
+
+  // Enabled again: the pin must be back on in hardware
+  gpio_enable_interrupt(BTN1_ch, true);
+  btn_click(BTN1_ch);
+  zassert_true(take_gpio_interrupt(BTN1_ch), "re-enabled interrupt not posted");
+  zassert_false(take_gpio_interrupt(BTN2_ch), "event of the other channel");
+
+  // The other pin of the port is not affected
+  btn_click(BTN2_ch);
+  zassert_true(take_gpio_interrupt(BTN2_ch), "other channel not posted");
+}
+
+ZTEST(gpio_abstract, test_isr_stats)
+{
+  Gpio_isr_stats_t before;
+  Gpio_isr_stats_t after;
+
+  get_gpio_isr_stats(&before);
+  for (uint8_t i = 0; i < 10; i++){
+    btn_click(BTN2_ch);
+  }
+  get_gpio_isr_stats(&after);
+  zassert_equal(after.count - before.count, 10, "dispatches %u", after.count - before.count);
+  zassert_equal(after.pins - before.pins, 10, "pins %u", after.pins - before.pins);
+  zassert_true(after.max_cycles >= before.max_cycles, "max cycles went down");
+  TC_PRINT("gpio dispatch: %u cycles max, %u cycles mean\n", after.max_cycles,
+           after.count ? after.total_cycles / after.count : 0);
+}
+
+ZTEST_SUITE(gpio_abstract, NULL, gpio_setup, gpio_before, NULL, NULL);
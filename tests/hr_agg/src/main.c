@@ -0,0 +1,189 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file main.c
+ * @brief accuracy and per-sample cost of the heart rate windowed aggregation
+ *
+ * Values are added with the sampling period of the adaptive rate as weight: the summary 
+ * must match the time weighted mean and percentiles computed exactly from the same values, 
+ * whatever the mix of fast and slow periods. On native_posix the cycle counter only follows 
+ * the simulated time, the cost per sample is meaningful on qemu_cortex_m3 or a board.
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+
+#include <zephyr/ztest.h>
+#include "hr_agg.h"
+#include "task_sched.h"
+
+#define TEST_VALUES       2000
+#define TEST_COST_MAX_CYC 2000    // per sample, Cortex-M class core
+
+static uint8_t bpm_set[TEST_VALUES];
+static uint32_t weight_set[TEST_VALUES];
+static uint32_t lcg_state;
+
+
+/***********************************************************
+ Static Function Definitions
+***********************************************************/
+/* hr_agg_window_set() re-arms the summary task, there is no scheduler in the test */
+void task_sched_set_period(Task_id_t id, uint32_t period_ms){
+  ARG_UNUSED(id);
+  ARG_UNUSED(period_ms);
+}
+
+static uint32_t lcg_next(void){
+  lcg_state = lcg_state * 1664525U + 1013904223U;
+  return lcg_state >> 8;
+}
+
+/* Exact time weighted percentile: smallest value whose cumulative weight reaches the rank */
+static uint8_t ref_percentile(const uint8_t *bpm, const uint32_t *w, uint16_t n, uint32_t total, uint8_t pct){
+  uint32_t rank = MAX((total * pct + 99U) / 100U, 1U);
+  uint32_t acc = 0;
+
+  for (uint16_t v = 0; v <= UINT8_MAX; v++){
+    for (uint16_t i = 0; i < n; i++){
+      acc += (bpm[i] == v) ? w[i] : 0U;
+    }
+    if (acc >= rank){
+      return (uint8_t)v;
+    }
+  }
+  return UINT8_MAX;
+}
+
+static void *agg_setup(void){
+  (void)hr_agg_window_set(60000);
+  return NULL;
+}
+
+static void agg_before(void *fixture){
+  Hr_agg_summary_t s;
+
+  ARG_UNUSED(fixture);
+  (void)hr_agg_window_set(60000);
+  (void)hr_agg_close(&s);
+}
+
+
+/***********************************************************
+ Tests
+***********************************************************/
+/* 10 s of exercise sampled every 20 ms, 50 s of rest sampled every 2 s */
+ZTEST(hr_agg, test_time_weighted){
+  Hr_agg_summary_t s;
+
+  for (uint16_t i = 0; i < 500; i++){
+    hr_agg_add(150, 20);
+  }
+  for (uint16_t i = 0; i < 25; i++){
+    hr_agg_add(60, 2000);
+  }
+  zassert_true(hr_agg_close(&s), "empty window");
+  zassert_equal(s.count, 525, "count %u", s.count);
+  // (150 * 10 s + 60 * 50 s) / 60 s, the sample mean would be 145.7
+  zassert_equal(s.mean_x10, 750, "mean %u", s.mean_x10);
+  zassert_within(s.p10, 60, HR_AGG_BUCKET_BPM / 2, "p10 %u", s.p10);
+  zassert_within(s.p50, 60, HR_AGG_BUCKET_BPM / 2, "p50 %u", s.p50);
+  zassert_within(s.p90, 150, HR_AGG_BUCKET_BPM / 2, "p90 %u", s.p90);
+  zassert_equal(s.min, 60, "min %u", s.min);
+  zassert_equal(s.max, 150, "max %u", s.max);
+}
+
+/* Random values and periods: error within half a bucket of the exact percentiles */
+ZTEST(hr_agg, test_accuracy){
+  Hr_agg_summary_t s;
+  uint64_t sum = 0;
+  uint32_t total = 0;
+
+  lcg_state = 4242U;
+  for (uint16_t i = 0; i < TEST_VALUES; i++){
+    bpm_set[i] = (uint8_t)(45U + lcg_next() % 140U);
+    weight_set[i] = 20U << (lcg_next() % 8U);   // 20 ms .. 2.56 s, as the adaptive rate
+    hr_agg_add(bpm_set[i], weight_set[i]);
+    sum += (uint64_t)bpm_set[i] * weight_set[i];
+    total += weight_set[i];
+  }
+  zassert_true(hr_agg_close(&s), "empty window");
+  zassert_equal(s.count, TEST_VALUES, "count %u", s.count);
+  zassert_equal(s.mean_x10, (uint16_t)((sum * 10U + total / 2U) / total), "mean %u", s.mean_x10);
+  zassert_within(s.p10, ref_percentile(bpm_set, weight_set, TEST_VALUES, total, 10), HR_AGG_BUCKET_BPM / 2,
+                 "p10 %u", s.p10);
+  zassert_within(s.p50, ref_percentile(bpm_set, weight_set, TEST_VALUES, total, 50), HR_AGG_BUCKET_BPM / 2,
+                 "p50 %u", s.p50);
+  zassert_within(s.p90, ref_percentile(bpm_set, weight_set, TEST_VALUES, total, 90), HR_AGG_BUCKET_BPM / 2,
+                 "p90 %u", s.p90);
+}
+
+/* One hour at the fastest period: 180000 values, none dropped, count saturated on the wire */
+ZTEST(hr_agg, test_long_window){
+  Hr_agg_summary_t s;
+  Hr_agg_stats_t before;
+  Hr_agg_stats_t after;
+  uint32_t n = HR_AGG_WINDOW_MAX_MS / 20U;
+
+  zassert_equal(hr_agg_window_set(HR_AGG_WINDOW_MAX_MS), 0, "window refused");
+  hr_agg_get_stats(&before);
+  for (uint32_t i = 0; i < n; i++){
+    hr_agg_add((i < n / 4U) ? 120 : 70, 20);
+  }
+  hr_agg_get_stats(&after);
+  zassert_true(hr_agg_close(&s), "empty window");
+  zassert_equal(after.samples - before.samples, n, "added %u of %u", after.samples - before.samples, n);
+  zassert_equal(s.count, UINT16_MAX, "count %u", s.count);
+  zassert_equal(s.window_s, HR_AGG_WINDOW_MAX_MS / 1000U, "window %u s", s.window_s);
+  zassert_equal(s.mean_x10, 825, "mean %u", s.mean_x10);
+  zassert_within(s.p50, 70, HR_AGG_BUCKET_BPM / 2, "p50 %u", s.p50);
+}
+
+/* A period longer than the window counts for the window only */
+ZTEST(hr_agg, test_weight_clamp){
+  Hr_agg_summary_t s;
+
+  zassert_equal(hr_agg_window_set(HR_AGG_WINDOW_MIN_MS), 0, "window refused");
+  hr_agg_add(100, 60000);
+  hr_agg_add(50, HR_AGG_WINDOW_MIN_MS);
+  zassert_true(hr_agg_close(&s), "empty window");
+  zassert_equal(s.mean_x10, 750, "mean %u", s.mean_x10);
+}
+
+ZTEST(hr_agg, test_cost_per_sample){
+  Hr_agg_summary_t s;
+  Hr_agg_stats_t before;
+  Hr_agg_stats_t after;
+  uint32_t samples;
+  uint32_t per_sample;
+
+  hr_agg_get_stats(&before);
+  lcg_state = 7U;
+  for (uint16_t i = 0; i < TEST_VALUES; i++){
+    hr_agg_add((uint8_t)(40U + lcg_next() % 180U), 20U << (lcg_next() % 8U));
+  }
+  hr_agg_get_stats(&after);
+  (void)hr_agg_close(&s);
+  samples = after.samples - before.samples;
+  per_sample = (after.cycles_total - before.cycles_total) / samples;
+  TC_PRINT("hr_agg_add(): %u cycles/sample (max %u) over %u samples\n", per_sample, after.cycles_max, samples);
+  zassert_equal(samples, TEST_VALUES, "samples %u", samples);
+  zassert_true(per_sample <= TEST_COST_MAX_CYC, "%u cycles/sample", per_sample);
+}
+
+ZTEST_SUITE(hr_agg, NULL, agg_setup, agg_before, NULL, NULL);
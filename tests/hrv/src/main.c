@@ -0,0 +1,186 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file main.c
+ * @brief reference check of the streaming heart rate variability metrics
+ *
+ * A pseudo random RR series is added to the window and, after each interval, the metrics 
+ * of hrv_get() are compared with SDNN, RMSSD and pNN50 computed from scratch (double) over 
+ * the same last HRV_WINDOW_BEATS intervals: the running sums must not drift while the window 
+ * slides.
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+
+#include <zephyr/ztest.h>
+#include "hrv.h"
+
+#define TEST_BEATS    (8 * HRV_WINDOW_BEATS)
+
+static uint16_t rr_series[TEST_BEATS];
+static uint32_t lcg_state;
+
+
+/***********************************************************
+ Static Function Definitions
+***********************************************************/
+static uint32_t lcg_next(void){
+  lcg_state = lcg_state * 1664525U + 1013904223U;
+  return lcg_state >> 8;
+}
+
+/* Newton iterations, the test does not depend on libm */
+static double ref_sqrt(double v){
+  double x = v > 1.0 ? v : 1.0;
+
+  if (v <= 0.0){
+    return 0.0;
+  }
+  for (int i = 0; i < 64; i++){
+    x = 0.5 * (x + v / x);
+  }
+  return x;
+}
+
+/* Slow drift, respiratory modulation and a few ectopic-like jumps, always in range */
+static void series_fill(void){
+  int32_t base = 800;
+
+  lcg_state = 12345U;
+  for (uint16_t i = 0; i < TEST_BEATS; i++){
+    int32_t rr;
+    base += (int32_t)(lcg_next() % 11U) - 5;
+    base = CLAMP(base, 500, 1200);
+    rr = base + (int32_t)(lcg_next() % 81U) - 40;
+    if (lcg_next() % 16U == 0){
+      rr += 150;
+    }
+    rr_series[i] = (uint16_t)CLAMP(rr, HRV_RR_MIN_MS, HRV_RR_MAX_MS);
+  }
+}
+
+/* Metrics of rr[0..n-1] computed from scratch, same units and rounding as Hrv_metrics_t */
+static void ref_metrics(const uint16_t *rr, uint16_t n, Hrv_metrics_t *m){
+  double mean = 0.0;
+  double m2 = 0.0;
+  double ssd = 0.0;
+  uint32_t nn50 = 0;
+
+  for (uint16_t i = 0; i < n; i++){
+    mean += rr[i];
+  }
+  mean /= n;
+  for (uint16_t i = 0; i < n; i++){
+    m2 += (rr[i] - mean) * (rr[i] - mean);
+  }
+  for (uint16_t i = 1; i < n; i++){
+    int32_t d = (int32_t)rr[i] - (int32_t)rr[i - 1];
+    ssd += (double)d * d;
+    nn50 += (d > HRV_NN50_MS || d < -HRV_NN50_MS) ? 1U : 0U;
+  }
+  m->beats = n;
+  m->mean_rr_ms = (uint16_t)(mean + 0.5);
+  m->sdnn_x10 = (uint16_t)(ref_sqrt(m2 / (n - 1)) * 10.0);
+  m->rmssd_x10 = (uint16_t)(ref_sqrt(ssd / (n - 1)) * 10.0);
+  m->pnn50_x10 = (uint16_t)(nn50 * 1000U / (n - 1U));
+}
+
+static void check_window(uint16_t added){
+  uint16_t n = MIN(added, HRV_WINDOW_BEATS);
+  Hrv_metrics_t got;
+  Hrv_metrics_t ref;
+
+  zassert_true(hrv_get(&got), "no metrics after %u intervals", added);
+  ref_metrics(&rr_series[added - n], n, &ref);
+  zassert_equal(got.beats, ref.beats, "beats %u != %u", got.beats, ref.beats);
+  // Integer square roots truncate, the Q16 mean rounds: 0.1 ms of tolerance
+  zassert_within(got.mean_rr_ms, ref.mean_rr_ms, 1, "interval %u: mean %u != %u", added,
+                 got.mean_rr_ms, ref.mean_rr_ms);
+  zassert_within(got.sdnn_x10, ref.sdnn_x10, 1, "interval %u: SDNN %u != %u", added, got.sdnn_x10,
+                 ref.sdnn_x10);
+  zassert_within(got.rmssd_x10, ref.rmssd_x10, 1, "interval %u: RMSSD %u != %u", added,
+                 got.rmssd_x10, ref.rmssd_x10);
+  zassert_equal(got.pnn50_x10, ref.pnn50_x10, "interval %u: pNN50 %u != %u", added, got.pnn50_x10,
+                ref.pnn50_x10);
+}
+
+static void *hrv_setup(void){
+  series_fill();
+  return NULL;
+}
+
+static void hrv_before(void *fixture){
+  ARG_UNUSED(fixture);
+  hrv_reset();
+}
+
+
+/***********************************************************
+ Tests
+***********************************************************/
+ZTEST(hrv, test_fill_and_slide){
+  for (uint16_t i = 0; i < TEST_BEATS; i++){
+    hrv_add_rr(rr_series[i]);
+    if (i >= 1){
+      check_window(i + 1);
+    }
+  }
+}
+
+ZTEST(hrv, test_short_window){
+  Hrv_metrics_t got;
+
+  zassert_false(hrv_get(&got), "metrics from an empty window");
+  hrv_add_rr(800);
+  zassert_false(hrv_get(&got), "metrics from a single interval");
+  zassert_equal(got.beats, 1, "beats %u", got.beats);
+}
+
+ZTEST(hrv, test_reject_out_of_range){
+  Hrv_stats_t before;
+  Hrv_stats_t after;
+  Hrv_metrics_t got;
+
+  hrv_get_stats(&before);
+  hrv_add_rr(800);
+  hrv_add_rr(HRV_RR_MIN_MS - 1);
+  hrv_add_rr(HRV_RR_MAX_MS + 1);
+  hrv_add_rr(860);
+  hrv_get_stats(&after);
+  zassert_equal(after.rejected - before.rejected, 2, "rejected %u", after.rejected - before.rejected);
+  zassert_equal(after.beats - before.beats, 2, "beats %u", after.beats - before.beats);
+  // The rejected intervals leave no successive difference: 800 -> 860 only
+  zassert_true(hrv_get(&got), "no metrics");
+  zassert_equal(got.beats, 2, "beats %u", got.beats);
+  zassert_equal(got.rmssd_x10, 600, "RMSSD %u", got.rmssd_x10);
+  zassert_equal(got.pnn50_x10, 1000, "pNN50 %u", got.pnn50_x10);
+}
+
+ZTEST(hrv, test_bpm_interval){
+  Hrv_metrics_t got;
+
+  hrv_add_bpm(75);
+  hrv_add_bpm(0);
+  hrv_add_bpm(80);
+  zassert_true(hrv_get(&got), "no metrics");
+  zassert_equal(got.beats, 2, "beats %u", got.beats);
+  zassert_equal(got.mean_rr_ms, 775, "mean %u", got.mean_rr_ms);
+}
+
+ZTEST_SUITE(hrv, NULL, hrv_setup, hrv_before, NULL, NULL);
@@ -0,0 +1,187 @@
+/******************************************************************************
+ * Copyright (c) 2025 Marconatale Parise.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ *****************************************************************************/
+/**
+ * @file main.c
+ * @brief single producer / single consumer ring under a concurrent producer
+ *
+ * The producer is a k_timer expiry function (ISR context, as the adc completion callback), 
+ * the consumer is the test thread popping small batches with spsc_ring_pop_batch(). Each 
+ * sample carries a sequence number: the consumer must see it strictly increasing, every 
+ * gap must be a sample dropped by the producer, and pushed = popped + overruns.
+ * 
+ * @author Marconatale Parise
+ * @date 09 June 2025
+ *
+ */
+
+#include <zephyr/ztest.h>
+#include <string.h>
+#include "spsc_ring.h"
+
+#define TEST_TICK_MS        1
+#define TEST_PUSH_PER_TICK  6       // producer bursts, faster than the consumer on purpose
+#define TEST_BATCH          5
+#define TEST_RUN_MS         500
+#define TEST_FAST_US        200     // consumer pause: 25 samples/ms, drains the ring
+#define TEST_SLOW_US        2000    // 2.5 samples/ms, the ring fills up and overruns
+
+static Spsc_ring_t ring;
+static struct k_timer producer_timer;
+static volatile uint32_t pushed;
+static volatile uint32_t rejected;
+static volatile bool producing;
+
+typedef struct
+{
+  uint32_t  popped;
+  uint32_t  gaps;       // sequence numbers missing in the popped stream
+  uint32_t  next_seq;
+}Test_consumer_t;
+
+
+/***********************************************************
+ Static Function Definitions
+***********************************************************/
+/* The slot content is derived from the sequence: a torn copy breaks the relation */
+static void sample_make(uint32_t seq, Adc_raw_sample_t *s){
+  s->ts_cyc = seq;
+  s->raw = (int16_t)(seq * 7U);
+  s->channel = (uint8_t)(seq ^ (seq >> 8));
+}
+
+static void producer_expiry(struct k_timer *timer){
+  Adc_raw_sample_t s;
+
+  ARG_UNUSED(timer);
+  if (!producing){
+    return;
+  }
+  for (uint8_t i = 0; i < TEST_PUSH_PER_TICK; i++){
+    sample_make(pushed, &s);
+    pushed++;
+    rejected += spsc_ring_push(&ring, &s) ? 0U : 1U;
+  }
+}
+
+static void consume(Test_consumer_t *c){
+  Adc_raw_sample_t out[TEST_BATCH];
+  uint32_t n = spsc_ring_pop_batch(&ring, out, ARRAY_SIZE(out));
+
+  zassert_true(n <= TEST_BATCH, "batch of %u", n);
+  for (uint32_t i = 0; i < n; i++){
+    Adc_raw_sample_t ref;
+    uint32_t seq = out[i].ts_cyc;
+
+    sample_make(seq, &ref);
+    zassert_true(seq >= c->next_seq, "sequence %u after %u", seq, c->next_seq);
+    zassert_equal(out[i].raw, ref.raw, "torn slot, sequence %u", seq);
+    zassert_equal(out[i].channel, ref.channel, "torn slot, sequence %u", seq);
+    c->gaps += seq - c->next_seq;
+    c->next_seq = seq + 1U;
+  }
+  c->popped += n;
+}
+
+static void ring_before(void *fixture){
+  ARG_UNUSED(fixture);
+  memset(&ring, 0, sizeof(ring));
+  pushed = 0;
+  rejected = 0;
+}
+
+
+/***********************************************************
+ Tests
+***********************************************************/
+ZTEST(spsc_ring, test_isr_producer){
+  Test_consumer_t c = {0};
+  uint32_t loops = 0;
+  int64_t end;
+
+  k_timer_init(&producer_timer, producer_expiry, NULL);
+  producing = true;
+  k_timer_start(&producer_timer, K_MSEC(TEST_TICK_MS), K_MSEC(TEST_TICK_MS));
+  end = k_uptime_get() + TEST_RUN_MS;
+  while (k_uptime_get() < end){
+    consume(&c);
+    // Phases faster (drain) and slower (overrun) than the producer, the timer interrupts 
+    // the consumer between and during the batches
+    k_busy_wait(((loops++ / 8U) % 2U) ? TEST_SLOW_US : TEST_FAST_US);
+  }
+  producing = false;
+  k_timer_stop(&producer_timer);
+  while (spsc_ring_count(&ring) > 0){
+    consume(&c);
+  }
+
+  TC_PRINT("pushed %u, popped %u, overruns %u\n", pushed, c.popped, ring.overruns);
+  zassert_true(pushed > SPSC_RING_CAPACITY, "producer did not run (%u)", pushed);
+  zassert_true(ring.overruns > 0, "consumer never fell behind");
+  zassert_equal(ring.overruns, rejected, "overruns %u, push refused %u", ring.overruns, rejected);
+  zassert_equal(pushed, c.popped + ring.overruns, "pushed %u != popped %u + overruns %u", pushed, c.popped,
+                ring.overruns);
+  // Only the dropped samples are missing from the stream, the tail of it included
+  zassert_equal(c.gaps + (pushed - c.next_seq), ring.overruns, "gaps %u, overruns %u",
+                c.gaps + (pushed - c.next_seq), ring.overruns);
+}
+
+ZTEST(spsc_ring, test_full_ring){
+  Adc_raw_sample_t s;
+  Adc_raw_sample_t out[SPSC_RING_CAPACITY];
+  uint32_t n;
+
+  for (uint32_t seq = 0; seq < SPSC_RING_CAPACITY + 5U; seq++){
+    sample_make(seq, &s);
+    zassert_equal(spsc_ring_push(&ring, &s), seq < SPSC_RING_CAPACITY, "push %u", seq);
+  }
+  zassert_equal(ring.overruns, 5, "overruns %u", ring.overruns);
+  zassert_equal(spsc_ring_count(&ring), SPSC_RING_CAPACITY, "count %u", spsc_ring_count(&ring));
+
+  n = spsc_ring_pop_batch(&ring, out, 3);
+  zassert_equal(n, 3, "batch %u", n);
+  n += spsc_ring_pop_batch(&ring, &out[3], ARRAY_SIZE(out) - 3U);
+  zassert_equal(n, SPSC_RING_CAPACITY, "popped %u", n);
+  for (uint32_t i = 0; i < n; i++){
+    zassert_equal(out[i].ts_cyc, i, "slot %u holds %u", i, out[i].ts_cyc);
+  }
+  zassert_equal(spsc_ring_pop_batch(&ring, out, ARRAY_SIZE(out)), 0, "empty ring popped");
+}
+
+/* Head and tail are free running: the order must survive their 32-bit wrap */
+ZTEST(spsc_ring, test_index_wrap){
+  Adc_raw_sample_t s;
+  Adc_raw_sample_t out[TEST_BATCH];
+  uint32_t next = 0;
+
+  atomic_set(&ring.head, (atomic_val_t)(UINT32_MAX - 7U));
+  atomic_set(&ring.tail, (atomic_val_t)(UINT32_MAX - 7U));
+  for (uint32_t seq = 0; seq < 64U; seq++){
+    sample_make(seq, &s);
+    zassert_true(spsc_ring_push(&ring, &s), "push %u", seq);
+    if (seq % 3U == 2U){
+      uint32_t n = spsc_ring_pop_batch(&ring, out, ARRAY_SIZE(out));
+      for (uint32_t i = 0; i < n; i++){
+        zassert_equal(out[i].ts_cyc, next, "got %u, expected %u", out[i].ts_cyc, next);
+        next++;
+      }
+    }
+  }
+  zassert_equal(spsc_ring_count(&ring), 64U - next, "count %u", spsc_ring_count(&ring));
+  zassert_equal(ring.overruns, 0, "overruns %u", ring.overruns);
+}
+
+ZTEST_SUITE(spsc_ring, NULL, NULL, ring_before, NULL, NULL);